@@ -0,0 +1,400 @@
+#include <JuceHeader.h>
+#include "../Source/Data/MidiGenerator.h"
+#include "../Source/Data/ConfigLookup.h"
+#include "../Source/Models/LayoutWrapper.h"
+#include "../Source/Models/ZoneWrapper.h"
+#include "../Source/Models/SettingsWrapper.h"
+#include "EventCapture.h"
+
+// Minimal processor, only here to own the AudioProcessorValueTreeState the wrappers and lookups work on
+class BenchProcessor : public juce::AudioProcessor {
+public:
+    BenchProcessor() : pluginState(*this, nullptr, "pluginState", {}) {}
+
+    const juce::String getName() const override { return "ecmapper_bench"; }
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return true; }
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+    void getStateInformation(juce::MemoryBlock&) override {}
+    void setStateInformation(const void*, int) override {}
+
+    juce::AudioProcessorValueTreeState pluginState;
+};
+
+struct BenchResult {
+    juce::int64 events = 0;
+    juce::int64 midiEvents = 0;
+    double totalSeconds = 0.0;
+    double worstBlockSeconds = 0.0;
+};
+
+static const int chordKeyStart = 100;
+static const int latchKeyStart = 110;
+
+// Alpha course 0: keys 0-99 notes, 100-109 four note chords, 110-119 latch CC keys. Strip 1 and breath are mapped too.
+// Course 1 key 0 triggers all notes off, only the stress mode presses it.
+static void createLayout(juce::ValueTree &rootState) {
+    for (int i = 0; i < 120; i++) {
+        LayoutWrapper::LayoutKey key {
+            .keyId = { .course = 0, .keyNo = i, .deviceType = DeviceType::Alpha },
+            .keyType = EigenharpKeyType::Normal,
+            .keyColour = KeyColour::Off,
+            .zone = Zone::Zone1,
+            .keyMappingType = KeyMappingType::Note,
+            .mappingValue = juce::String(24 + i%100)
+        };
+        if (i >= latchKeyStart) {
+            key.keyMappingType = KeyMappingType::MidiMsg;
+            key.mappingValue = "Latch;CC;" + juce::String(20 + i - latchKeyStart) + ";0;127";
+        }
+        else if (i >= chordKeyStart) {
+            int root = 48 + i - chordKeyStart;
+            key.keyMappingType = KeyMappingType::Chord;
+            key.mappingValue = "Chord;" + juce::String(root) + ";" + juce::String(root+4) + ";" + juce::String(root+7) + ";" + juce::String(root+11);
+        }
+        LayoutWrapper::setLayoutKey(key, rootState);
+    }
+    LayoutWrapper::LayoutKey allNotesOffKey {
+        .keyId = { .course = 1, .keyNo = 0, .deviceType = DeviceType::Alpha },
+        .keyType = EigenharpKeyType::Normal,
+        .keyColour = KeyColour::Off,
+        .zone = Zone::Zone1,
+        .keyMappingType = KeyMappingType::MidiMsg,
+        .mappingValue = "Trigger;AllNotesOff;0;0;0"
+    };
+    LayoutWrapper::setLayoutKey(allNotesOffKey, rootState);
+    ZoneWrapper::setMidiValue(DeviceType::Alpha, Zone::Zone1, ZoneWrapper::id_strip1Abs, { .valueType = MidiValueType::CC, .ccNo = 1 }, rootState);
+    ZoneWrapper::setMidiValue(DeviceType::Alpha, Zone::Zone1, ZoneWrapper::id_strip1Rel, { .valueType = MidiValueType::Pitchbend, .ccNo = 0 }, rootState);
+}
+
+static OSC::Message createKeyMessage(int key, bool active, juce::Random &random, int course = 0) {
+    OSC::Message msg;
+    msg.type = OSC::MessageType::Key;
+    msg.device = DeviceType::Alpha;
+    msg.course = course;
+    msg.key = key;
+    msg.active = active ? 1 : 0;
+    msg.pressure = active ? 200 + random.nextInt(3800) : 0;
+    msg.roll = random.nextInt(4096) - 2048;
+    msg.yaw = random.nextInt(4096) - 2048;
+    return msg;
+}
+
+// Every block each held key sends messagesPerKey updates. Keys are released and re-pressed in rotation so that
+// note on/off, channel allocation and latch toggling are part of the measured path.
+static BenchResult runScenario(MidiGenerator &midiGenerator, int simultaneousKeys, int blocks, int messagesPerKey) {
+    BenchResult result;
+    juce::Random random(simultaneousKeys);
+    juce::MidiBuffer midiBuffer;
+    OSC::Message outgoingMsg;
+    std::vector<int> heldKeys;
+    for (int i = 0; i < simultaneousKeys; i++)
+        heldKeys.push_back((i*37)%120);
+
+    int nextKey = 0;
+    for (int block = 0; block < blocks; block++) {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        midiBuffer.clear();
+        int blockEvents = 0;
+
+        for (int m = 0; m < messagesPerKey; m++) {
+            for (auto key : heldKeys) {
+                auto msg = createKeyMessage(key, true, random);
+                midiGenerator.processOSCMessage(msg, outgoingMsg, midiBuffer);
+                blockEvents++;
+            }
+        }
+
+        OSC::Message breathMsg;
+        breathMsg.type = OSC::MessageType::Breath;
+        breathMsg.device = DeviceType::Alpha;
+        breathMsg.value = 2048 + random.nextInt(2000);
+        midiGenerator.processOSCMessage(breathMsg, outgoingMsg, midiBuffer);
+
+        OSC::Message stripMsg;
+        stripMsg.type = OSC::MessageType::Strip;
+        stripMsg.device = DeviceType::Alpha;
+        stripMsg.strip = 1;
+        stripMsg.active = 1;
+        stripMsg.value = 150 + random.nextInt(3000);
+        midiGenerator.processOSCMessage(stripMsg, outgoingMsg, midiBuffer);
+        blockEvents += 2;
+
+        if (!heldKeys.empty() && block%4 == 0) {
+            int slot = nextKey++ % (int)heldKeys.size();
+            auto offMsg = createKeyMessage(heldKeys[slot], false, random);
+            midiGenerator.processOSCMessage(offMsg, outgoingMsg, midiBuffer);
+            heldKeys[slot] = (heldKeys[slot] + 1)%120;
+            blockEvents++;
+        }
+
+        auto blockSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        result.totalSeconds += blockSeconds;
+        result.worstBlockSeconds = std::max(result.worstBlockSeconds, blockSeconds);
+        result.events += blockEvents;
+        result.midiEvents += midiBuffer.getNumEvents();
+    }
+
+    for (auto key : heldKeys) {
+        auto offMsg = createKeyMessage(key, false, random);
+        midiGenerator.processOSCMessage(offMsg, outgoingMsg, midiBuffer);
+    }
+    return result;
+}
+
+// Feeds an EigenCore capture through the receive queue in blocks of blockMicros capture time, the same way
+// processBlock drains oscReceiveQueue, and measures the time spent per block.
+static BenchResult runReplay(MidiGenerator &midiGenerator, const juce::File &file, juce::uint32 blockMicros) {
+    BenchResult result;
+    EventCapture::Reader reader;
+    if (!reader.open(file)) {
+        std::cout << "Not a valid capture file: " << file.getFullPathName() << std::endl;
+        return result;
+    }
+
+    OSC::OSCMessageFifo receiveQueue;
+    juce::MidiBuffer midiBuffer;
+    OSC::Message msg;
+    OSC::Message outgoingMsg;
+    EventCapture::Record record;
+    bool hasRecord = reader.read(record);
+    juce::uint32 blockEnd = blockMicros;
+    while (hasRecord) {
+        while (hasRecord && record.captureTime < blockEnd && receiveQueue.getMessageCount() < OSC::queueSize-1) {
+            if (record.type != EventCapture::Disconnect) {
+                msg.type = (OSC::MessageType)record.type;
+                msg.device = (DeviceType)record.device;
+                msg.course = record.course;
+                msg.key = record.type == EventCapture::Key ? record.index : 0;
+                msg.strip = record.type == EventCapture::Strip ? record.index : 0;
+                msg.pedal = record.type == EventCapture::Pedal ? record.index : 0;
+                msg.active = record.active;
+                msg.pressure = record.type == EventCapture::Key ? record.value : 0;
+                msg.value = record.type == EventCapture::Key ? 0 : record.value;
+                msg.roll = record.roll;
+                msg.yaw = record.yaw;
+                receiveQueue.add(&msg);
+            }
+            hasRecord = reader.read(record);
+        }
+        blockEnd += blockMicros;
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        midiBuffer.clear();
+        int blockEvents = receiveQueue.getMessageCount();
+        while (receiveQueue.getMessageCount() > 0) {
+            receiveQueue.read(&msg);
+            if (msg.type != OSC::MessageType::Device)
+                midiGenerator.processOSCMessage(msg, outgoingMsg, midiBuffer);
+        }
+        auto blockSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        result.totalSeconds += blockSeconds;
+        result.worstBlockSeconds = std::max(result.worstBlockSeconds, blockSeconds);
+        result.events += blockEvents;
+        result.midiEvents += midiBuffer.getNumEvents();
+    }
+    return result;
+}
+
+// Follows the MIDI that comes out of the generator the way a synth would see it.
+struct NoteTracker {
+    bool sounding[16][128] = {};
+    int noteOns = 0;
+    int duplicateNoteOns = 0;
+    
+    void process(const juce::MidiBuffer &buffer) {
+        for (const auto metadata : buffer) {
+            auto message = metadata.getMessage();
+            if (message.isNoteOn()) {
+                auto &note = sounding[message.getChannel()-1][message.getNoteNumber()];
+                duplicateNoteOns += note ? 1 : 0;
+                note = true;
+                noteOns++;
+            }
+            else if (message.isNoteOff()) {
+                sounding[message.getChannel()-1][message.getNoteNumber()] = false;
+            }
+            else if (message.isAllNotesOff()) {
+                for (auto &note : sounding[message.getChannel()-1])
+                    note = false;
+            }
+        }
+    }
+    
+    int getSoundingCount() const {
+        int count = 0;
+        for (auto &channel : sounding)
+            for (auto note : channel)
+                count += note ? 1 : 0;
+        return count;
+    }
+};
+
+// Random presses (some released before the note on), pressure updates, releases, latch toggles and all notes off.
+// The generator invariants are checked after every step and the MIDI output must not contain a note on for a note
+// that is already sounding, nor leave notes sounding once every key is released.
+static bool runStress(MidiGenerator &midiGenerator, juce::int64 seed, int steps, BenchResult &result, juce::String &problem) {
+    juce::Random random(seed);
+    juce::MidiBuffer midiBuffer;
+    OSC::Message outgoingMsg;
+    NoteTracker tracker;
+    bool held[120] = {};
+    std::vector<int> heldKeys;
+    
+    auto send = [&](OSC::Message msg) {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        midiGenerator.processOSCMessage(msg, outgoingMsg, midiBuffer);
+        result.totalSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        result.events++;
+    };
+    
+    for (int step = 0; step <= steps; step++) {
+        midiBuffer.clear();
+        auto secondsBefore = result.totalSeconds;
+        int action = random.nextInt(100);
+        if (step == steps) {
+            for (auto key : heldKeys)
+                send(createKeyMessage(key, false, random));
+            heldKeys.clear();
+        }
+        else if (action < 40 && (int)heldKeys.size() < 120) {
+            int key = random.nextInt(120);
+            while (held[key])
+                key = (key + 1)%120;
+            held[key] = true;
+            heldKeys.push_back(key);
+            for (int i = random.nextInt(MidiGenerator::PRESSURE_HISTORY_LENGTH + 3); i >= 0; i--)
+                send(createKeyMessage(key, true, random));
+        }
+        else if (action < 75) {
+            for (auto key : heldKeys)
+                send(createKeyMessage(key, true, random));
+        }
+        else if (action < 98 && !heldKeys.empty()) {
+            int slot = random.nextInt((int)heldKeys.size());
+            send(createKeyMessage(heldKeys[slot], false, random));
+            held[heldKeys[slot]] = false;
+            heldKeys.erase(heldKeys.begin() + slot);
+        }
+        else {
+            send(createKeyMessage(0, true, random, 1));
+            send(createKeyMessage(0, false, random, 1));
+        }
+        
+        tracker.process(midiBuffer);
+        result.midiEvents += midiBuffer.getNumEvents();
+        result.worstBlockSeconds = std::max(result.worstBlockSeconds, result.totalSeconds - secondsBefore);
+        if (!midiGenerator.checkInvariants(problem)) {
+            problem = "step " + juce::String(step) + ": " + problem;
+            return false;
+        }
+        if (tracker.duplicateNoteOns > 0) {
+            problem = "step " + juce::String(step) + ": note on for a note that is already sounding";
+            return false;
+        }
+    }
+    
+    if (tracker.getSoundingCount() > 0) {
+        problem = juce::String(tracker.getSoundingCount()) + " notes still sounding after all keys were released";
+        return false;
+    }
+    if (midiGenerator.getMPEChannelOccupancy() > 0.0f) {
+        problem = "MPE channels still occupied after all keys were released";
+        return false;
+    }
+    return true;
+}
+
+static void printResult(const juce::String &name, const BenchResult &result) {
+    std::cout << name << "\t"
+        << result.events << "\t"
+        << result.midiEvents << "\t"
+        << juce::String(result.totalSeconds*1.0e9/(double)std::max(result.events, (juce::int64)1), 1) << "\t"
+        << juce::String((double)result.events/std::max(result.totalSeconds, 1.0e-9), 0) << "\t"
+        << juce::String(result.worstBlockSeconds*1.0e6, 1) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--unit-tests")) {
+        juce::UnitTestRunner runner;
+        runner.runTestsInCategory("ECMapper");
+        int failures = 0;
+        for (int i = 0; i < runner.getNumResults(); i++)
+            failures += runner.getResult(i)->failures;
+        return failures > 0 ? 1 : 0;
+    }
+    int blocks = args.containsOption("--blocks") ? args.getValueForOption("--blocks").getIntValue() : 20000;
+    int messagesPerKey = args.containsOption("--rate") ? args.getValueForOption("--rate").getIntValue() : 8;
+
+    BenchProcessor processor;
+    createLayout(processor.pluginState.state);
+    ConfigLookup configLookups[3] { ConfigLookup(DeviceType::Alpha, processor.pluginState), ConfigLookup(DeviceType::Tau, processor.pluginState), ConfigLookup(DeviceType::Pico, processor.pluginState) };
+    MidiGenerator midiGenerator(configLookups);
+    midiGenerator.start(processor.pluginState);
+
+    if (args.containsOption("--stress")) {
+        auto seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : juce::Time::currentTimeMillis();
+        int steps = args.containsOption("--steps") ? args.getValueForOption("--steps").getIntValue() : 100000;
+        double minRate = args.containsOption("--min-rate") ? args.getValueForOption("--min-rate").getDoubleValue() : 0.0;
+        struct StressConfig {
+            const char *name;
+            MidiChannelType channelType;
+            int stealPolicy;
+        };
+        // four lower zone voices, so stealing happens all the time
+        SettingsWrapper::setLowerMPEVoiceCount(4, processor.pluginState.state);
+        midiGenerator.stop();
+        
+        std::cout << "seed: " << seed << ", steps: " << steps << std::endl;
+        std::cout << "config\tevents\tmidi out\tns/event\tevents/s\tworst step (us)" << std::endl;
+        bool passed = true;
+        for (auto config : { StressConfig { "mpe-oldest", MidiChannelType::MPE_Low, 1 }, StressConfig { "mpe-newest", MidiChannelType::MPE_Low, 2 },
+                             StressConfig { "mpe-share", MidiChannelType::MPE_Low, 3 }, StressConfig { "channel1", MidiChannelType::Chan1, 1 } }) {
+            ZoneWrapper::setMidiChannelType(DeviceType::Alpha, Zone::Zone1, config.channelType, processor.pluginState.state);
+            SettingsWrapper::setMPEStealPolicy(config.stealPolicy, processor.pluginState.state);
+            midiGenerator.start(processor.pluginState);
+            
+            BenchResult result;
+            juce::String problem;
+            bool ok = runStress(midiGenerator, seed, steps, result, problem);
+            printResult(config.name, result);
+            if (!ok)
+                std::cout << "FAILED " << config.name << ": " << problem << std::endl;
+            
+            double rate = (double)result.events/std::max(result.totalSeconds, 1.0e-9);
+            if (ok && rate < minRate)
+                std::cout << "FAILED " << config.name << ": " << juce::String(rate, 0) << " events/s is below " << juce::String(minRate, 0) << std::endl;
+            passed = passed && ok && rate >= minRate;
+            midiGenerator.stop();
+        }
+        return passed ? 0 : 1;
+    }
+
+    if (args.containsOption("--replay")) {
+        // the capture is replayed against the synthetic Alpha layout, other devices only exercise the lookups
+        std::cout << "scenario\tevents\tmidi out\tns/event\tevents/s\tworst block (us)" << std::endl;
+        printResult("replay", runReplay(midiGenerator, args.getExistingFileForOption("--replay"), 5333));
+        midiGenerator.stop();
+        return 0;
+    }
+
+    std::cout << "blocks: " << blocks << ", messages per key per block: " << messagesPerKey << std::endl;
+    std::cout << "keys\tevents\tmidi out\tns/event\tevents/s\tworst block (us)" << std::endl;
+    for (int keys : { 1, 4, 16, 48, 120 })
+        printResult(juce::String(keys), runScenario(midiGenerator, keys, blocks, messagesPerKey));
+
+    midiGenerator.stop();
+    return 0;
+}
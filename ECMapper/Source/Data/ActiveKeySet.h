@@ -0,0 +1,54 @@
+#pragma once
+#include <JuceHeader.h>
+#include "MPEChannelAllocator.h"
+#if JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+// Key indexes (see MidiGenerator::getKeyIndex) of the keys that are down, as a bitset. forEach() skips empty
+// words and walks the set bits of the others, so housekeeping costs the number of held keys instead of a scan
+// over every key of every instrument.
+class ActiveKeySet {
+public:
+    static const int MAX_KEYS = MPEChannelAllocator::MAX_KEYS;
+
+    void add(int keyIndex) { words[keyIndex >> 6] |= bit(keyIndex); }
+    void remove(int keyIndex) { words[keyIndex >> 6] &= ~bit(keyIndex); }
+    bool contains(int keyIndex) const { return (words[keyIndex >> 6] & bit(keyIndex)) != 0; }
+    void clear() { memset(words, 0, sizeof(words)); }
+
+    bool isEmpty() const {
+        for (auto word : words) {
+            if (word != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // f(keyIndex) may remove keyIndex from the set
+    template <typename Function>
+    void forEach(Function f) const {
+        for (int i = 0; i < WORDS; i++) {
+            auto remaining = words[i];
+            while (remaining != 0) {
+                f(i*64 + lowestBit(remaining));
+                remaining &= remaining - 1;
+            }
+        }
+    }
+
+private:
+    static const int WORDS = (MAX_KEYS + 63)/64;
+    juce::uint64 words[WORDS] = {};
+
+    static juce::uint64 bit(int keyIndex) { return (juce::uint64)1 << (keyIndex & 63); }
+    static int lowestBit(juce::uint64 word) {
+#if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return (int)index;
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+};
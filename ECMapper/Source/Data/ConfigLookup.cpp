@@ -2,9 +2,11 @@
 
 ConfigLookup::ConfigLookup(DeviceType deviceType, juce::AudioProcessorValueTreeState &pluginState) : pluginState(pluginState) {
     this->deviceType = deviceType;
+    keys.resize(DeviceGeometry::keyCount((int)deviceType));
 }
 
 void ConfigLookup::updateAll() {
+    TRACE_SPAN("ConfigLookup::updateAll");
     this->controlLights = SettingsWrapper::getControlLights(deviceType, pluginState.state);
 
     juce::ValueTree layoutTree = LayoutWrapper::getLayoutTree(deviceType, pluginState.state);
@@ -21,7 +23,7 @@ void ConfigLookup::updateAll() {
 }
 
 void ConfigLookup::updateKey(juce::ValueTree keytree) {
-    if (!keytree.getType().toString().startsWith(LayoutWrapper::id_key + "_"))
+    if (!LayoutWrapper::isKeyTree(keytree))
         return;
     
     LayoutWrapper::LayoutKey layoutKey = LayoutWrapper::getLayoutKeyFromKeyTree(keytree);
@@ -112,7 +114,9 @@ void ConfigLookup::updateKey(juce::ValueTree keytree) {
             }
         }
     }
-    keys[layoutKey.keyId.course][layoutKey.keyId.keyNo] = key;
+    auto keySlot = getKey(layoutKey.keyId.course, layoutKey.keyId.keyNo);
+    if (keySlot != nullptr)
+        *keySlot = key;
 }
 
 void ConfigLookup::updateBreath(Zone zone) {
@@ -163,3 +167,30 @@ void ConfigLookup::updateStrips(Zone zone) {
     strip2[((int)zone)-1].absMidiValue = ZoneWrapper::getMidiValue(deviceType, zone, ZoneWrapper::id_strip2Abs, ZoneWrapper::default_strip2Abs, pluginState.state);
     strip2[((int)zone)-1].relMidiValue = ZoneWrapper::getMidiValue(deviceType, zone, ZoneWrapper::id_strip2Rel, ZoneWrapper::default_strip2Rel, pluginState.state);
 }
+
+Subscription::DeviceFilter ConfigLookup::getSubscription() const {
+    Subscription::DeviceFilter filter;
+    for (int i = 0; i < (int)keys.size(); i++) {
+        auto &key = keys[i];
+        if (key.output == MidiChannelType::Undefined)
+            continue;
+        int course = DeviceGeometry::courseOf((int)deviceType, i);
+        int keyNo = DeviceGeometry::keyOf((int)deviceType, i);
+        // note on waits for a few pressure updates and notes follow the key, commands only need press and release
+        if (key.mapType == KeyMappingType::Note || key.mapType == KeyMappingType::Chord)
+            filter.addKey(course, keyNo, true);
+        else if (key.mapType == KeyMappingType::MidiMsg)
+            filter.addKey(course, keyNo, false);
+    }
+    
+    for (int i = 0; i < 3; i++) {
+        if (breath[i].midiValue.valueType != MidiValueType::Off)
+            filter.flags |= Subscription::Breath;
+        if (strip1[i].absMidiValue.valueType != MidiValueType::Off || strip1[i].relMidiValue.valueType != MidiValueType::Off)
+            filter.flags |= Subscription::Strip1;
+        if (strip2[i].absMidiValue.valueType != MidiValueType::Off || strip2[i].relMidiValue.valueType != MidiValueType::Off)
+            filter.flags |= Subscription::Strip2;
+    }
+    // MidiGenerator does nothing with pedals yet
+    return filter;
+}
@@ -5,6 +5,9 @@
 #include "../Models/SettingsWrapper.h"
 #include "../Models/Enums.h"
 #include "../UI/Utility.h"
+#include "SpanTrace.h"
+#include "Subscription.h"
+#include "DeviceGeometry.h"
 
 
 class ConfigLookup {
@@ -14,6 +17,8 @@ public:
     void updateKey(juce::ValueTree keytree);
     void updateBreath(Zone zone);
     void updateStrips(Zone zone);
+    // the keys and controllers MidiGenerator does something with, for EigenCore to filter on
+    Subscription::DeviceFilter getSubscription() const;
 
     struct Key {
         LayoutWrapper::KeyId keyId;
@@ -44,7 +49,12 @@ public:
         int channel = 0;
     };
 
-    Key keys[3][120];
+    // one per key the device has, by DeviceGeometry::keyIndex()
+    std::vector<Key> keys;
+    Key* getKey(int course, int keyNo) {
+        int index = DeviceGeometry::keyIndex((int)deviceType, course, keyNo);
+        return index < 0 ? nullptr : &keys[index];
+    }
     Breath breath[3];
     Strip strip1[3];
     Strip strip2[3];
@@ -1,15 +1,17 @@
 #include "LayoutChangeHandler.h"
 
-LayoutChangeHandler::LayoutChangeHandler(OSC::OSCMessageFifo *oscSendQueue, ECMapperAudioProcessor *processor, ConfigLookup (&configLookups) [3]) {
+LayoutChangeHandler::LayoutChangeHandler(OSC::OSCMessageFifo *oscSendQueue, ECMapperAudioProcessor *processor, ConfigLookup (&configLookups) [3], MidiGenerator *midiGenerator) {
     this->configLookups = configLookups;
+    this->midiGenerator = midiGenerator;
     this->oscSendQueue = oscSendQueue;
     this->processor = processor;
 }
 
 void LayoutChangeHandler::valueTreePropertyChanged(juce::ValueTree &vTree, const juce::Identifier &property) {
+    TRACE_SPAN("LayoutChangeHandler::valueTreePropertyChanged");
     processor->suspendProcessing(true);
     DeviceType deviceType = DeviceType::None;
-    if (vTree.getType().toString().startsWith(LayoutWrapper::id_key + "_")) {
+    if (LayoutWrapper::isKeyTree(vTree)) {
         LayoutWrapper::LayoutKey layoutKey = LayoutWrapper::getLayoutKeyFromKeyTree(vTree);
         deviceType = layoutKey.keyId.deviceType;
         
@@ -21,16 +23,21 @@ void LayoutChangeHandler::valueTreePropertyChanged(juce::ValueTree &vTree, const
                 configLookups[configIndex].updateKey(vTree);
         }
     }
-    else if (vTree.getParent().getType().toString().startsWith(ZoneWrapper::id_zone)) {
+    else if (ZoneWrapper::isZoneTree(vTree.getParent())) {
         DeviceType deviceType = ZoneWrapper::getDeviceTypeFromTree(vTree);
         configLookups[((int)deviceType) - 1].updateAll();
+        resetHighResCCs(deviceType, vTree.getParent());
     }
-    else if (vTree.getType().toString().startsWith(ZoneWrapper::id_zone)) {
+    else if (ZoneWrapper::isZoneTree(vTree)) {
         DeviceType deviceType = ZoneWrapper::getDeviceTypeFromTree(vTree);
         configLookups[((int)deviceType) - 1].updateAll();
+        resetHighResCCs(deviceType, vTree);
+        // fixed channel zones get their pitchbend range RPN on the new channel
+        if (property == ZoneWrapper::id_midiChannelType || property == ZoneWrapper::id_channelMaxPitchbend || property == ZoneWrapper::id_enabled)
+            midiGenerator->createLayoutRPNs(processor->pluginState);
     }
-    else if (property == SettingsWrapper::id_controlLights && vTree.getType().toString().startsWith(LayoutWrapper::id_device)) {
-        DeviceType deviceType = (DeviceType)vTree.getType().toString().substring(6, 7).getIntValue();
+    else if (property == SettingsWrapper::id_controlLights && ModelCache::getDeviceType(vTree.getType()) != DeviceType::None) {
+        DeviceType deviceType = ModelCache::getDeviceType(vTree.getType());
         juce::ValueTree root = vTree.getRoot();
         configLookups[((int)deviceType) - 1].controlLights = SettingsWrapper::getControlLights(deviceType, root);
         sendLEDMsgForAllKeys(deviceType);
@@ -39,6 +46,14 @@ void LayoutChangeHandler::valueTreePropertyChanged(juce::ValueTree &vTree, const
     processor->suspendProcessing(false);
 }
 
+// a value changed to or from 14-bit, or moved to another CC or channel, must not be taken for the pair last sent
+void LayoutChangeHandler::resetHighResCCs(DeviceType deviceType, const juce::ValueTree &zoneTree) {
+    Zone zone = ModelCache::getZone(zoneTree.getType());
+    if (deviceType == DeviceType::None || zone == Zone::NoZone)
+        return;
+    midiGenerator->resetHighResCCs(ZoneWrapper::getMidiChannelType(deviceType, zone, processor->pluginState.state));
+}
+
 int LayoutChangeHandler::getConfigIndexFromDeviceType(DeviceType type) {
     return (int)type - 1;
 }
@@ -62,7 +77,8 @@ void LayoutChangeHandler::sendLEDMsg(LayoutWrapper::LayoutKey layoutKey) {
         .value = (unsigned int)layoutKey.keyColour,
         .pedal = 0,
         .strip = 0,
-        .device = layoutKey.keyId.deviceType
+        .device = layoutKey.keyId.deviceType,
+        .instance = OSC::AllInstances
     };
     oscSendQueue->add(&msg);
 }
@@ -100,7 +116,7 @@ void LayoutChangeHandler::sendLEDMsgForAllKeys(DeviceType deviceType) {
 }
 
 void LayoutChangeHandler::valueTreeChildAdded(juce::ValueTree &parentTree, juce::ValueTree &childTree) {
-    if (childTree.getType().toString().startsWith(LayoutWrapper::id_key + "_")) {
+    if (LayoutWrapper::isKeyTree(childTree)) {
         LayoutWrapper::LayoutKey layoutKey = LayoutWrapper::getLayoutKeyFromKeyTree(childTree);
         if (layoutKey.keyId.deviceType != DeviceType::None) {
             sendLEDMsg(layoutKey);
@@ -5,15 +5,15 @@
 #include "../Models/Enums.h"
 #include "../Models/LayoutWrapper.h"
 #include "ConfigLookup.h"
+#include "MidiGenerator.h"
 
 class ECMapperAudioProcessor;
 
 class LayoutChangeHandler : public juce::ValueTree::Listener {
 public:
-    LayoutChangeHandler(OSC::OSCMessageFifo *oscSendQueue, ECMapperAudioProcessor *processor, ConfigLookup (&configLookups) [3]);
+    LayoutChangeHandler(OSC::OSCMessageFifo *oscSendQueue, ECMapperAudioProcessor *processor, ConfigLookup (&configLookups) [3], MidiGenerator *midiGenerator);
     void sendLEDMsg(LayoutWrapper::LayoutKey layoutKey);
     void sendLEDMsgForAllKeys(DeviceType deviceType);
-    bool layoutMidiRPNSent = false;
 
 private:
     void valueTreePropertyChanged(juce::ValueTree &vTree, const juce::Identifier &property);
@@ -26,7 +26,9 @@ private:
     OSC::OSCMessageFifo *oscSendQueue;
     
     int getConfigIndexFromDeviceType(DeviceType type);
+    void resetHighResCCs(DeviceType deviceType, const juce::ValueTree &zoneTree);
     ConfigLookup *configLookups;
+    MidiGenerator *midiGenerator;
     ECMapperAudioProcessor *processor;
 };
 
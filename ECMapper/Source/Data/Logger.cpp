@@ -1,29 +1,133 @@
 #include "Logger.h"
 
-ECMLogger::ECMLogger(bool logToFile, bool logToConsole) {
+static const char *levelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+ECMLogger::ECMLogger(bool logToFile, bool logToConsole, Level minLevel) : juce::Thread("ECMLogger"), minLevel(minLevel) {
     this->logToFile = logToFile;
     this->logToConsole = logToConsole;
-    if (logToFile) {
-        logFile = new juce::File(logPath + timeToLogTimeStamp(juce::Time::getCurrentTime()));
-    }
+    for (juce::uint32 i = 0; i < LOGGER_QUEUE_SIZE; i++)
+        records[i].sequence.store(i, std::memory_order_relaxed);
+    
+    if (logToFile)
+        openLogFile();
+    startThread();
 }
 
 ECMLogger::~ECMLogger() {
-    if (logFile != nullptr)
-        delete logFile;
+    stopThread(1000);
 }
 
-void ECMLogger::log(juce::String text) {
+// Bounded multi producer queue: each record's sequence tells whether it is free for position n (sequence == n)
+// or holds the record written at position n (sequence == n+1), so writers only race on writePosition.
+void ECMLogger::log(const char *text, Level level) {
+    if (level < minLevel.load(std::memory_order_relaxed))
+        return;
+    
+    auto position = writePosition.load(std::memory_order_relaxed);
+    Record *record;
+    while (true) {
+        record = &records[position % LOGGER_QUEUE_SIZE];
+        auto sequence = record->sequence.load(std::memory_order_acquire);
+        auto diff = (juce::int32)(sequence - position);
+        if (diff == 0) {
+            if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0) {
+            droppedRecords++;
+            return;
+        }
+        else {
+            position = writePosition.load(std::memory_order_relaxed);
+        }
+    }
+    
+    record->time = juce::Time::currentTimeMillis();
+    record->level = level;
+    strncpy(record->text, text, LOGGER_TEXT_SIZE - 1);
+    record->text[LOGGER_TEXT_SIZE - 1] = 0;
+    record->sequence.store(position + 1, std::memory_order_release);
+}
+
+void ECMLogger::log(const juce::String &text, Level level) {
+    log(text.toRawUTF8(), level);
+}
+
+bool ECMLogger::readRecord(juce::int64 &time, Level &level, char *text) {
+    auto &record = records[readPosition % LOGGER_QUEUE_SIZE];
+    if (record.sequence.load(std::memory_order_acquire) != readPosition + 1)
+        return false;
+    
+    time = record.time;
+    level = record.level;
+    memcpy(text, record.text, LOGGER_TEXT_SIZE);
+    record.sequence.store(readPosition + LOGGER_QUEUE_SIZE, std::memory_order_release);
+    readPosition++;
+    return true;
+}
+
+void ECMLogger::run() {
+    juce::int64 time;
+    Level level;
+    char text[LOGGER_TEXT_SIZE];
+    bool exiting = false;
+    while (!exiting) {
+        exiting = threadShouldExit();
+        bool written = false;
+        while (readRecord(time, level, text)) {
+            writeLine(juce::Time(time).formatted("%H:%M:%S.") + juce::String(time % 1000).paddedLeft('0', 3)
+                      + " " + levelNames[(int)level] + " " + juce::String(juce::CharPointer_UTF8(text)));
+            written = true;
+        }
+        
+        auto dropped = droppedRecords.exchange(0);
+        if (dropped > 0) {
+            writeLine(juce::String(dropped) + " log records dropped");
+            written = true;
+        }
+        
+        if (written && logStream != nullptr) {
+            logStream->flush();
+            if (logStream->getPosition() > LOGGER_MAX_FILE_SIZE)
+                openLogFile();
+        }
+        
+        if (!exiting)
+            wait(50);
+    }
+}
+
+void ECMLogger::writeLine(const juce::String &line) {
     if (logToConsole)
-        std::cout << text << std::endl;
+        std::cout << line << std::endl;
     
-    if (logToFile) {
-        logFile->appendText(timeToLogTimeStamp(juce::Time::getCurrentTime()) + ": ");
-        logFile->appendText(text);
-        logFile->appendText(juce::NewLine());
+    if (logStream != nullptr)
+        logStream->writeText(line + juce::NewLine(), false, false, nullptr);
+}
+
+void ECMLogger::openLogFile() {
+    logStream = nullptr;
+    juce::File logFile(logPath + timeToLogTimeStamp(juce::Time::getCurrentTime()) + ".log");
+    logFile.getParentDirectory().createDirectory();
+    logStream = std::make_unique<juce::FileOutputStream>(logFile);
+    if (logStream->failedToOpen()) {
+        std::cout << "Unable to open log file " << logFile.getFullPathName() << std::endl;
+        logStream = nullptr;
     }
+    deleteOldLogFiles();
 }
 
+void ECMLogger::deleteOldLogFiles() {
+    auto logFiles = juce::File(logPath).findChildFiles(juce::File::findFiles, false, "*.log");
+    if (logFiles.size() <= LOGGER_MAX_FILES)
+        return;
+    
+    std::sort(logFiles.begin(), logFiles.end(), [](const juce::File &a, const juce::File &b) {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+    for (int i = 0; i < logFiles.size() - LOGGER_MAX_FILES; i++)
+        logFiles[i].deleteFile();
+}
 
 juce::String ECMLogger::timeToLogTimeStamp(juce::Time time) {
     return juce::String(time.getYear()) + "_"
@@ -34,4 +138,3 @@ juce::String ECMLogger::timeToLogTimeStamp(juce::Time time) {
         + juce::String(time.getSeconds()) + "_"
         + juce::String(time.getMilliseconds());
 };
-
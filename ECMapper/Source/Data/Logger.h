@@ -2,17 +2,53 @@
 
 #include <JuceHeader.h>
 
-class ECMLogger {
+#define LOGGER_QUEUE_SIZE 1024
+#define LOGGER_TEXT_SIZE 112
+#define LOGGER_MAX_FILE_SIZE (4*1024*1024)
+#define LOGGER_MAX_FILES 10
+
+// log() only copies the text into a fixed size record in a lock-free ring, so it is safe to call from processBlock.
+// A background thread formats the records and writes them to the console and to one open log file, which is
+// rotated when it gets bigger than LOGGER_MAX_FILE_SIZE. Lines longer than LOGGER_TEXT_SIZE are cut off.
+class ECMLogger : private juce::Thread {
 public:
-    ECMLogger(bool logToFile, bool logToConsole);
+    enum class Level {
+        Debug = 0,
+        Info = 1,
+        Warning = 2,
+        Error = 3
+    };
+    
+    ECMLogger(bool logToFile, bool logToConsole, Level minLevel = Level::Info);
     ~ECMLogger();
-    void log(juce::String text);
+    void log(const char *text, Level level = Level::Info);
+    void log(const juce::String &text, Level level = Level::Info);
+    void setMinLevel(Level level) { minLevel = level; }
     
 private:
+    struct Record {
+        std::atomic<juce::uint32> sequence { 0 };
+        juce::int64 time = 0;
+        Level level = Level::Info;
+        char text[LOGGER_TEXT_SIZE];
+    };
+    
+    void run() override;
+    bool readRecord(juce::int64 &time, Level &level, char *text);
+    void writeLine(const juce::String &line);
+    void openLogFile();
+    void deleteOldLogFiles();
+    
     bool logToFile;
     bool logToConsole;
+    std::atomic<Level> minLevel;
     juce::String logPath = "~/Documents/ECMapperLogs/";
-    juce::File *logFile = nullptr;
+    std::unique_ptr<juce::FileOutputStream> logStream;
+    
+    Record records[LOGGER_QUEUE_SIZE];
+    std::atomic<juce::uint32> writePosition { 0 };
+    juce::uint32 readPosition = 0;
+    std::atomic<int> droppedRecords { 0 };
     
     juce::String timeToLogTimeStamp(juce::Time time);
 };
@@ -0,0 +1,127 @@
+#include "MPEChannelAllocator.h"
+
+MPEChannelAllocator::MPEChannelAllocator() {
+    memset(keyChannelIndex, -1, sizeof(keyChannelIndex));
+}
+
+void MPEChannelAllocator::setZone(const juce::MPEZoneLayout::Zone &zone) {
+    channelCount = zone.isActive() ? std::min(zone.numMemberChannels, 15) : 0;
+    masterChannel = zone.getMasterChannel();
+    int direction = zone.isLowerZone() ? 1 : -1;
+    for (int i = 0; i < channelCount; i++) {
+        channels[i] = Channel();
+        channels[i].midiChannel = zone.getFirstMemberChannel() + i*direction;
+    }
+    allNotesOff();
+    stealCount = 0;
+}
+
+void MPEChannelAllocator::setStealPolicy(StealPolicy policy) {
+    stealPolicy = policy;
+}
+
+int MPEChannelAllocator::noteOn(int keyIndex, int &stolenKeyIndex) {
+    stolenKeyIndex = NO_KEY;
+    if (channelCount == 0 || keyIndex < 0 || keyIndex >= MAX_KEYS)
+        return masterChannel;
+
+    if (keyChannelIndex[keyIndex] >= 0)
+        return channels[keyChannelIndex[keyIndex]].midiChannel;
+
+    // a stolen or shared channel stays occupied, it only changes hands
+    int index = findFreeChannel();
+    bool wasFree = index >= 0;
+    if (index < 0) {
+        index = findChannelToSteal();
+        if (stealPolicy != StealPolicy::Share) {
+            stolenKeyIndex = channels[index].ownerKey;
+            if (stolenKeyIndex != NO_KEY)
+                keyChannelIndex[stolenKeyIndex] = -1;
+            channels[index].noteCount = 0;
+            stealCount++;
+        }
+    }
+
+    Channel &channel = channels[index];
+    if (wasFree)
+        occupiedChannels++;
+    channel.noteCount++;
+    channel.ownerKey = keyIndex;
+    channel.lastNoteOn = ++clock;
+    keyChannelIndex[keyIndex] = (juce::int8)index;
+    return channel.midiChannel;
+}
+
+void MPEChannelAllocator::noteOff(int keyIndex) {
+    if (keyIndex < 0 || keyIndex >= MAX_KEYS || keyChannelIndex[keyIndex] < 0)
+        return;
+
+    Channel &channel = channels[keyChannelIndex[keyIndex]];
+    keyChannelIndex[keyIndex] = -1;
+    channel.noteCount = std::max(channel.noteCount - 1, 0);
+    if (channel.ownerKey == keyIndex)
+        channel.ownerKey = NO_KEY;
+    if (channel.noteCount == 0) {
+        channel.lastNoteOff = ++clock;
+        occupiedChannels--;
+    }
+}
+
+void MPEChannelAllocator::allNotesOff() {
+    for (int i = 0; i < channelCount; i++) {
+        channels[i].noteCount = 0;
+        channels[i].ownerKey = NO_KEY;
+    }
+    memset(keyChannelIndex, -1, sizeof(keyChannelIndex));
+    occupiedChannels = 0;
+}
+
+int MPEChannelAllocator::getChannelForKey(int keyIndex) const {
+    if (keyIndex < 0 || keyIndex >= MAX_KEYS || keyChannelIndex[keyIndex] < 0)
+        return 0;
+    return channels[keyChannelIndex[keyIndex]].midiChannel;
+}
+
+int MPEChannelAllocator::getChannelCount() const {
+    return channelCount;
+}
+
+int MPEChannelAllocator::getOccupiedChannelCount() const {
+    return occupiedChannels;
+}
+
+int MPEChannelAllocator::getStealCount() const {
+    return stealCount;
+}
+
+// The channel released longest ago gets the new note, giving the synth's release tail the most time to finish
+int MPEChannelAllocator::findFreeChannel() const {
+    int found = -1;
+    for (int i = 0; i < channelCount; i++) {
+        if (channels[i].noteCount == 0 && (found < 0 || channels[i].lastNoteOff < channels[found].lastNoteOff))
+            found = i;
+    }
+    return found;
+}
+
+int MPEChannelAllocator::findChannelToSteal() const {
+    int found = 0;
+    for (int i = 1; i < channelCount; i++) {
+        switch (stealPolicy) {
+            case StealPolicy::Oldest:
+                if (channels[i].lastNoteOn < channels[found].lastNoteOn)
+                    found = i;
+                break;
+            case StealPolicy::Newest:
+                if (channels[i].lastNoteOn > channels[found].lastNoteOn)
+                    found = i;
+                break;
+            case StealPolicy::Share:
+                if (channels[i].noteCount < channels[found].noteCount
+                    || (channels[i].noteCount == channels[found].noteCount && channels[i].lastNoteOn < channels[found].lastNoteOn))
+                    found = i;
+                break;
+        }
+    }
+    return found;
+}
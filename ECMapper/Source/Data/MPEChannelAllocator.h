@@ -0,0 +1,53 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include "OSCMessageQueue.h"
+#include "DeviceGeometry.h"
+
+// Fixed size MPE channel allocator for one zone. Free channels are handed out least recently used first,
+// and when every member channel is busy the steal policy decides which key gives up its channel.
+class MPEChannelAllocator {
+public:
+    enum class StealPolicy {
+        Oldest = 1,  // steal the channel whose note started first
+        Newest = 2,  // steal the channel whose note started last
+        Share = 3    // never steal, put the note on the least busy channel
+    };
+
+    static const int MAX_KEYS = OSC::MaxInstances*DeviceGeometry::AllKeys; // see MidiGenerator::getKeyIndex()
+    static const int NO_KEY = -1;
+
+    MPEChannelAllocator();
+    void setZone(const juce::MPEZoneLayout::Zone &zone);
+    void setStealPolicy(StealPolicy policy);
+    int noteOn(int keyIndex, int &stolenKeyIndex);
+    void noteOff(int keyIndex);
+    void allNotesOff();
+    int getChannelForKey(int keyIndex) const;
+
+    int getChannelCount() const;
+    int getOccupiedChannelCount() const;
+    int getStealCount() const;
+
+private:
+    struct Channel {
+        int midiChannel = 0;
+        int noteCount = 0;
+        int ownerKey = NO_KEY;
+        juce::uint32 lastNoteOn = 0;
+        juce::uint32 lastNoteOff = 0;
+    };
+
+    Channel channels[15];
+    int channelCount = 0;
+    int masterChannel = 1;
+    juce::int8 keyChannelIndex[MAX_KEYS];
+    juce::uint32 clock = 0;
+    StealPolicy stealPolicy = StealPolicy::Oldest;
+
+    std::atomic<int> occupiedChannels { 0 };
+    std::atomic<int> stealCount { 0 };
+
+    int findFreeChannel() const;
+    int findChannelToSteal() const;
+};
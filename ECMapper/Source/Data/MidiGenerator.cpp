@@ -2,34 +2,43 @@
 
 MidiGenerator::MidiGenerator(ConfigLookup (&configLookups)[3]) : velocityCurve(0.0, 0.0, 0.0, 1.0, 0.5, 0.6, 1.0, 1.0) {
     this->configLookups = configLookups;
+    for (int i = 0; i < 3; i++) {
+        for (int n = 0; n < OSC::MaxInstances; n++)
+            instruments[i].push_back(std::make_unique<InstrumentState>(i + 1));
+    }
 }
 
 MidiGenerator::~MidiGenerator() {
-    delete lowerChanAssigner;
-    delete upperChanAssigner;
 }
 
-void MidiGenerator::start(juce::AudioProcessorValueTreeState &pluginState) {
-    int lowerChannelCount = SettingsWrapper::getLowerMPEVoiceCount(pluginState.state);
-    mpeZone.setLowerZone(lowerChannelCount, 2, SettingsWrapper::getLowerMPEPB(pluginState.state));
-    if (lowerChanAssigner != nullptr) {
-        delete lowerChanAssigner;
-        lowerChanAssigner = nullptr;
-    }
+MidiGenerator::InstrumentState* MidiGenerator::getInstrument(int deviceIndex, int instance) {
+    if (deviceIndex < 0 || deviceIndex > 2 || instance < 0 || instance >= OSC::MaxInstances)
+        return nullptr;
+    return instruments[deviceIndex][instance].get();
+}
 
-    if (upperChanAssigner != nullptr) {
-        delete upperChanAssigner;
-        upperChanAssigner = nullptr;
-    }
+MidiGenerator::KeyState& MidiGenerator::getKeyState(int keyIndex) {
+    return instruments[getKeyDeviceIndex(keyIndex)][getKeyInstance(keyIndex)]->keyStates[getKeyFlatIndex(keyIndex)];
+}
 
-    lowerChanAssigner = new juce::MPEChannelAssigner(mpeZone.getLowerZone());
+ConfigLookup::Key& MidiGenerator::getKeyLookup(int keyIndex) {
+    return configLookups[getKeyDeviceIndex(keyIndex)].keys[getKeyFlatIndex(keyIndex)];
+}
+
+void MidiGenerator::start(juce::AudioProcessorValueTreeState &pluginState) {
+    int lowerChannelCount = SettingsWrapper::getLowerMPEVoiceCount(pluginState.state);
+    mpeZone.clearAllZones();
+    mpeZone.setLowerZone(lowerChannelCount, SettingsWrapper::getLowerMPEPB(pluginState.state), 2);
     if (lowerChannelCount < 14) {
         int upperChannelCount = SettingsWrapper::getUpperMPEVoiceCount(pluginState.state);
-        mpeZone.setUpperZone(upperChannelCount, 2, SettingsWrapper::getUpperMPEPB(pluginState.state));
-        upperChanAssigner = new juce::MPEChannelAssigner(mpeZone.getUpperZone());
+        mpeZone.setUpperZone(upperChannelCount, SettingsWrapper::getUpperMPEPB(pluginState.state), 2);
     }
-    else
-        upperChanAssigner = nullptr;
+
+    auto stealPolicy = (MPEChannelAllocator::StealPolicy)SettingsWrapper::getMPEStealPolicy(pluginState.state);
+    lowerChanAllocator.setZone(mpeZone.getLowerZone());
+    lowerChanAllocator.setStealPolicy(stealPolicy);
+    upperChanAllocator.setZone(mpeZone.getUpperZone());
+    upperChanAllocator.setStealPolicy(stealPolicy);
     
     configLookups[0].updateAll();
     configLookups[1].updateAll();
@@ -41,70 +50,194 @@ void MidiGenerator::start(juce::AudioProcessorValueTreeState &pluginState) {
         currentStripPBperChannel[i] = 0;
         currentKeyPBperChannel[i] = 0;
         chanNotePri[i].clear();
+        for (int j = 0; j < 32; j++) {
+            lastHighResMSB[i][j] = -1;
+            lastHighResLSB[i][j] = -1;
+        }
     }
     
+    createLayoutRPNs(pluginState);
     initialized = true;
 }
 
 void MidiGenerator::stop() {
     initialized = false;
-    if (lowerChanAssigner != nullptr)
-        delete lowerChanAssigner;
-    if (upperChanAssigner != nullptr)
-        delete upperChanAssigner;
-    lowerChanAssigner = nullptr;
-    upperChanAssigner = nullptr;
+    lowerChanAllocator.allNotesOff();
+    upperChanAllocator.allNotesOff();
+}
+
+float MidiGenerator::getMPEChannelOccupancy() const {
+    int channelCount = lowerChanAllocator.getChannelCount() + upperChanAllocator.getChannelCount();
+    if (channelCount == 0)
+        return 0.0f;
+    return (lowerChanAllocator.getOccupiedChannelCount() + upperChanAllocator.getOccupiedChannelCount())/(float)channelCount;
+}
+
+int MidiGenerator::getMPEStealCount() const {
+    return lowerChanAllocator.getStealCount() + upperChanAllocator.getStealCount();
+}
+
+bool MidiGenerator::checkInvariants(juce::String &problem) const {
+    int expectedNotes[16][128] = {};
+    int expectedPriorities[16] = {};
+    for (int d = 0; d < 3; d++) {
+        for (int n = 0; n < (int)instruments[d].size(); n++) {
+            for (int k = 0; k < (int)instruments[d][n]->keyStates.size(); k++) {
+                auto &state = instruments[d][n]->keyStates[k];
+                auto &keyLookup = configLookups[d].keys[k];
+                bool isNoteKey = keyLookup.mapType == KeyMappingType::Note || keyLookup.mapType == KeyMappingType::Chord;
+                if (!isNoteKey || state.status != KeyStatus::Active)
+                    continue;
+                
+                auto keyIndex = getKeyIndex(d, n, k);
+                auto keyName = "key " + juce::String(d) + "/" + juce::String(n) + "/" + juce::String(DeviceGeometry::courseOf(d + 1, k))
+                    + "/" + juce::String(DeviceGeometry::keyOf(d + 1, k));
+                if (state.midiChannel < 1 || state.midiChannel > 16) {
+                    problem = keyName + " is active on channel " + juce::String(state.midiChannel);
+                    return false;
+                }
+                
+                int allocatedChannel = -1;
+                if (keyLookup.output == MidiChannelType::MPE_Low)
+                    allocatedChannel = lowerChanAllocator.getChannelForKey(keyIndex);
+                else if (keyLookup.output == MidiChannelType::MPE_High)
+                    allocatedChannel = upperChanAllocator.getChannelForKey(keyIndex);
+                if (allocatedChannel != -1 && allocatedChannel != state.midiChannel) {
+                    problem = keyName + " plays on channel " + juce::String(state.midiChannel) + " but holds channel " + juce::String(allocatedChannel);
+                    return false;
+                }
+                
+                bool hasPriority = false;
+                for (auto priorityKeyIndex : chanNotePri[state.midiChannel-1]) {
+                    if (priorityKeyIndex == keyIndex)
+                        hasPriority = true;
+                }
+                if (!hasPriority) {
+                    problem = keyName + " is missing from the priority list of channel " + juce::String(state.midiChannel);
+                    return false;
+                }
+                expectedPriorities[state.midiChannel-1]++;
+                
+                for (int i = 0; i < 4; i++) {
+                    if (keyLookup.notes[i] > -1)
+                        expectedNotes[state.midiChannel-1][keyLookup.notes[i]]++;
+                }
+            }
+        }
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        if ((int)chanNotePri[i].size() != expectedPriorities[i]) {
+            problem = "channel " + juce::String(i+1) + " has " + juce::String((int)chanNotePri[i].size()) + " priority entries for "
+                + juce::String(expectedPriorities[i]) + " active keys";
+            return false;
+        }
+    }
+    
+    for (auto &note : playingNotes) {
+        if (note.channnel < 1 || note.channnel > 16 || note.noteNumber < 0 || note.noteNumber > 127 || --expectedNotes[note.channnel-1][note.noteNumber] < 0) {
+            problem = "note " + juce::String(note.noteNumber) + " on channel " + juce::String(note.channnel) + " is playing without an active key";
+            return false;
+        }
+    }
+    for (int channel = 0; channel < 16; channel++) {
+        for (int note = 0; note < 128; note++) {
+            if (expectedNotes[channel][note] > 0) {
+                problem = "note " + juce::String(note) + " on channel " + juce::String(channel+1) + " is held by a key but not playing";
+                return false;
+            }
+        }
+    }
+    
+    if (lowerChanAllocator.getOccupiedChannelCount() > lowerChanAllocator.getChannelCount()
+        || upperChanAllocator.getOccupiedChannelCount() > upperChanAllocator.getChannelCount()) {
+        problem = "MPE allocator occupies more channels than the zone has";
+        return false;
+    }
+    return true;
 }
 
 void MidiGenerator::processOSCMessage(OSC::Message &oscMsg, OSC::Message &outgoingOscMsg, juce::MidiBuffer &midiBuffer) {
     if (!initialized)
         return;
     
+    switch (oscMsg.device) {
+        case DeviceType::Alpha:
+            processDeviceMessage<(int)DeviceType::Alpha>(oscMsg, outgoingOscMsg, midiBuffer);
+            break;
+        case DeviceType::Tau:
+            processDeviceMessage<(int)DeviceType::Tau>(oscMsg, outgoingOscMsg, midiBuffer);
+            break;
+        case DeviceType::Pico:
+            processDeviceMessage<(int)DeviceType::Pico>(oscMsg, outgoingOscMsg, midiBuffer);
+            break;
+        default:
+            break;
+    }
+}
+
+template <int Type>
+void MidiGenerator::processDeviceMessage(OSC::Message &oscMsg, OSC::Message &outgoingOscMsg, juce::MidiBuffer &midiBuffer) {
+    typedef DeviceTraits<Type> Traits;
+    auto &configLookup = configLookups[Traits::deviceIndex];
+    
     switch (oscMsg.type) {
         case OSC::MessageType::Key: {
-                int deviceIndex = (int)oscMsg.device -1;
-                KeyState *keyState = &keyStates[deviceIndex][oscMsg.course][oscMsg.key];
-                keyState->ehYaw = oscMsg.yaw;
-                keyState->ehRoll = oscMsg.roll;
-                keyState->ehPressureHistory.push_back(oscMsg.pressure);
-                while (keyState->ehPressureHistory.size() > PRESSURE_HISTORY_LENGTH)
-                    keyState->ehPressureHistory.pop_front();
-
-                ConfigLookup::Key keyLookup = configLookups[deviceIndex].keys[oscMsg.course][oscMsg.key];
+                auto instrument = getInstrument(Traits::deviceIndex, oscMsg.instance);
+                int index = DeviceGeometry::keyIndex(Type, oscMsg.course, oscMsg.key);
+                if (instrument == nullptr || index < 0)
+                    break;
+                KeyState *keyState = &instrument->keyStates[index];
+                keyState->lastUpdate = juce::Time::getMillisecondCounter();
+                keyState->ehYaw = (juce::int16)oscMsg.yaw;
+                keyState->ehRoll = (juce::int16)oscMsg.roll;
+                keyState->addPressure(oscMsg.pressure);
+
+                ConfigLookup::Key keyLookup = configLookup.keys[index];
                 if (keyLookup.output == MidiChannelType::Undefined)
                     break;
                 
+                int keyIndex = getKeyIndex(Traits::deviceIndex, oscMsg.instance, index);
                 if (keyLookup.mapType == KeyMappingType::Note || keyLookup.mapType == KeyMappingType::Chord)
-                    processNoteKey(oscMsg, keyLookup, keyState, midiBuffer);
+                    processNoteKey(oscMsg, keyLookup, keyState, keyIndex, midiBuffer);
                 else if (keyLookup.mapType == KeyMappingType::MidiMsg)
                     processCmdKey(oscMsg, outgoingOscMsg, keyLookup, keyState, midiBuffer);
+                
+                if (keyState->status == KeyStatus::Off)
+                    activeKeys.remove(keyIndex);
+                else
+                    activeKeys.add(keyIndex);
             }
             break;
         case OSC::MessageType::Breath: {
-                int deviceIndex = (int)oscMsg.device -1;
-                unsigned int prevBreathValue = ehBreath[deviceIndex];
-                ehBreath[deviceIndex] = std::abs((int)(oscMsg.value - 2048))*2;
-                if ((ehBreath[deviceIndex] > breathZeroThreshold[deviceIndex]) || (ehBreath[deviceIndex] < breathZeroThreshold[deviceIndex] && prevBreathValue > 0)) {
-                    createBreath(deviceIndex, configLookups[deviceIndex], midiBuffer);
+                auto instrument = getInstrument(Traits::deviceIndex, oscMsg.instance);
+                if (instrument == nullptr)
+                    break;
+                unsigned int prevBreathValue = instrument->ehBreath;
+                instrument->ehBreath = std::abs((int)(oscMsg.value - 2048))*2;
+                if ((instrument->ehBreath > Traits::breathZeroThreshold) || (instrument->ehBreath < Traits::breathZeroThreshold && prevBreathValue > 0)) {
+                    createBreath(Traits::breathZeroThreshold, *instrument, configLookup, midiBuffer);
                 }
             }
             break;
         case OSC::MessageType::Strip: {
                 int stripIndex = oscMsg.strip - 1;
+                auto instrument = getInstrument(Traits::deviceIndex, oscMsg.instance);
+                if (instrument == nullptr || stripIndex < 0 || stripIndex >= Traits::strips)
+                    break;
                 stripMessageCount[stripIndex]++;
-                int deviceIndex = (int)oscMsg.device -1;
                 bool stripOff = !oscMsg.active;
-                ehStrips[stripIndex][deviceIndex] = stripOff ? 0.0f : std::max((((int)oscMsg.value) - 150) * 1.5f, 0.0f);
+                instrument->ehStrips[stripIndex] = stripOff ? 0.0f : std::max((((int)oscMsg.value) - 150) * 1.5f, 0.0f);
                 if (stripOff)
-                    relStart_ehStrips[stripIndex][deviceIndex] = -1;
-                else if (relStart_ehStrips[stripIndex][deviceIndex] < 0)
-                    relStart_ehStrips[stripIndex][deviceIndex] = ehStrips[stripIndex][deviceIndex];
+                    instrument->relStart_ehStrips[stripIndex] = -1;
+                else if (instrument->relStart_ehStrips[stripIndex] < 0)
+                    instrument->relStart_ehStrips[stripIndex] = instrument->ehStrips[stripIndex];
 
                 for (int i = 0; i < 3; i++) {
                     if (!stripOff) {
-                        createStripAbsolute(deviceIndex, stripIndex, i, configLookups[deviceIndex], midiBuffer);
+                        createStripAbsolute(*instrument, stripIndex, i, configLookup, midiBuffer);
                     }
-                    createStripRelative(deviceIndex, stripIndex, i, configLookups[deviceIndex], midiBuffer);
+                    createStripRelative(*instrument, stripIndex, i, configLookup, midiBuffer);
                 }
                 stripMessageCount[stripIndex] = 0;
             }
@@ -117,25 +250,32 @@ void MidiGenerator::processOSCMessage(OSC::Message &oscMsg, OSC::Message &outgoi
     }
 
     // Don't send LED data for latch keys if Control Lights setting is unchecked
-    int deviceIndex = (int)oscMsg.device -1;
-    if (!configLookups[deviceIndex].controlLights && outgoingOscMsg.type == OSC::MessageType::LED)
+    if (!configLookup.controlLights && outgoingOscMsg.type == OSC::MessageType::LED)
         outgoingOscMsg.type = OSC::MessageType::Undefined;
 }
 
-void MidiGenerator::processNoteKey(OSC::Message &oscMsg, ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer) {
+void MidiGenerator::processNoteKey(OSC::Message &oscMsg, ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer) {
     state->messageCount++;
 
-    if (!oscMsg.active) {
-        createNoteOff(keyLookup, state, buffer);
+    // a stolen key already sent its note off, a pending one never sent a note on
+    if (!oscMsg.active && (state->status == KeyStatus::Stolen || state->status == KeyStatus::Pending)) {
+        state->status = KeyStatus::Off;
+        state->messageCount = 0;
+    }
+    else if (!oscMsg.active) {
+        createNoteOff(keyLookup, state, keyIndex, buffer);
+    }
+    else if (state->status == KeyStatus::Stolen) {
+        // the channel went to a newer key, stay silent until this key is released
     }
     else if (state->status == KeyStatus::Off && oscMsg.active) {
         state->status = KeyStatus::Pending;
     }
     else if (state->messageCount == PRESSURE_HISTORY_LENGTH && state->status == KeyStatus::Pending && oscMsg.active) {
-        createNoteOn(keyLookup, state, buffer);
+        createNoteOn(keyLookup, state, keyIndex, buffer);
     }
     else if (state->messageCount == 64 && state->status != KeyStatus::Pending) {
-        createNoteHold(keyLookup, state, buffer);
+        createNoteHold(keyLookup, state, keyIndex, buffer);
     }
 }
 
@@ -153,58 +293,85 @@ void MidiGenerator::processCmdKey(OSC::Message &oscMsg, OSC::Message &outgoingOs
     state->status = oscMsg.active ? KeyStatus::Active : KeyStatus::Off;
 }
 
+void MidiGenerator::releaseStuckKeys(juce::MidiBuffer &buffer) {
+    if (activeKeys.isEmpty())
+        return;
+    
+    auto now = juce::Time::getMillisecondCounter();
+    activeKeys.forEach([&](int keyIndex) {
+        auto &state = getKeyState(keyIndex);
+        auto &keyLookup = getKeyLookup(keyIndex);
+        // command keys only get presses and releases from EigenCore, see ConfigLookup::getSubscription()
+        bool isNoteKey = keyLookup.mapType == KeyMappingType::Note || keyLookup.mapType == KeyMappingType::Chord;
+        if (!isNoteKey || now - state.lastUpdate < (juce::uint32)STUCK_KEY_TIMEOUT_MS)
+            return;
+        
+        OSC::Message release;
+        release.type = OSC::MessageType::Key;
+        release.active = 0;
+        processNoteKey(release, keyLookup, &state, keyIndex, buffer);
+        activeKeys.remove(keyIndex);
+        stuckKeyCount.fetch_add(1, std::memory_order_relaxed);
+    });
+}
+
 void MidiGenerator::reduceBreath(juce::MidiBuffer &buffer) {
     for (int i = 0; i < 3; i++) {
-        if (ehBreath[i] == 0)
-            continue;
-        
-        ehBreath[i] = ehBreath[i] > breathZeroThreshold[i] ? ehBreath[i] - 20 : 0;
-        createBreath(i, configLookups[i], buffer);
+        for (auto &instrument : instruments[i]) {
+            if (instrument->ehBreath == 0)
+                continue;
+            
+            instrument->ehBreath = instrument->ehBreath > breathZeroThreshold[i] ? instrument->ehBreath - 20 : 0;
+            createBreath(breathZeroThreshold[i], *instrument, configLookups[i], buffer);
+        }
     }
 }
 
-void MidiGenerator::createBreath(int deviceIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer) {
-    ehBreath[deviceIndex] = ehBreath[deviceIndex] < breathZeroThreshold[deviceIndex] ? 0 : ehBreath[deviceIndex] - breathZeroThreshold[deviceIndex];
+void MidiGenerator::createBreath(unsigned int zeroThreshold, InstrumentState &instrument, ConfigLookup &keyLookup, juce::MidiBuffer &buffer) {
+    instrument.ehBreath = instrument.ehBreath < zeroThreshold ? 0 : instrument.ehBreath - zeroThreshold;
     
-    addMidiValueMessage(keyLookup.breath[0].channel, ehBreath[deviceIndex]*3, keyLookup.breath[0].midiValue, 1.0f, 0, buffer, false);
-    addMidiValueMessage(keyLookup.breath[1].channel, ehBreath[deviceIndex]*3, keyLookup.breath[1].midiValue, 1.0f, 0, buffer, false);
-    addMidiValueMessage(keyLookup.breath[2].channel, ehBreath[deviceIndex]*3, keyLookup.breath[2].midiValue, 1.0f, 0, buffer, false);
+    addMidiValueMessage(keyLookup.breath[0].channel, instrument.ehBreath*3, keyLookup.breath[0].midiValue, 1.0f, 0, buffer, false);
+    addMidiValueMessage(keyLookup.breath[1].channel, instrument.ehBreath*3, keyLookup.breath[1].midiValue, 1.0f, 0, buffer, false);
+    addMidiValueMessage(keyLookup.breath[2].channel, instrument.ehBreath*3, keyLookup.breath[2].midiValue, 1.0f, 0, buffer, false);
 }
 
-void MidiGenerator::createStripAbsolute(int deviceIndex, int stripIndex, int zoneIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer) {
+void MidiGenerator::createStripAbsolute(InstrumentState &instrument, int stripIndex, int zoneIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer) {
     
     stripIndex == 0
-        ? addStripValueMessage(keyLookup.strip1[zoneIndex].channel, ehStrips[stripIndex][deviceIndex], keyLookup.strip1[zoneIndex].absMidiValue, buffer, false)
-        : addStripValueMessage(keyLookup.strip2[zoneIndex].channel, ehStrips[stripIndex][deviceIndex], keyLookup.strip2[zoneIndex].absMidiValue, buffer, false);
+        ? addStripValueMessage(keyLookup.strip1[zoneIndex].channel, instrument.ehStrips[stripIndex], keyLookup.strip1[zoneIndex].absMidiValue, buffer, false)
+        : addStripValueMessage(keyLookup.strip2[zoneIndex].channel, instrument.ehStrips[stripIndex], keyLookup.strip2[zoneIndex].absMidiValue, buffer, false);
 }
 
-void MidiGenerator::createStripRelative(int deviceIndex, int stripIndex, int zoneIndex, ConfigLookup &keyLookup,
+void MidiGenerator::createStripRelative(InstrumentState &instrument, int stripIndex, int zoneIndex, ConfigLookup &keyLookup,
     juce::MidiBuffer &buffer) {
     int relValue;
 
-    if (relStart_ehStrips[stripIndex][deviceIndex] < 0) {
+    if (instrument.relStart_ehStrips[stripIndex] < 0) {
         relValue = 1;
         currentStripPBperChannel[keyLookup.strip1[zoneIndex].channel] = 0;
     }
     else
-        relValue = relStart_ehStrips[stripIndex][deviceIndex] - ehStrips[stripIndex][deviceIndex];
+        relValue = instrument.relStart_ehStrips[stripIndex] - instrument.ehStrips[stripIndex];
 
     stripIndex == 0
         ? addStripValueMessage(keyLookup.strip1[zoneIndex].channel, relValue, keyLookup.strip1[zoneIndex].relMidiValue, buffer, true)
         : addStripValueMessage(keyLookup.strip2[zoneIndex].channel, relValue, keyLookup.strip2[zoneIndex].relMidiValue, buffer, true);
 }
 
-void MidiGenerator::createNoteOn(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer) {
-    if (keyLookup.output == MidiChannelType::MPE_Low && lowerChanAssigner != nullptr)
-        state->midiChannel = lowerChanAssigner->findMidiChannelForNewNote(keyLookup.notes[0]);
-    else if (keyLookup.output == MidiChannelType::MPE_High && upperChanAssigner != nullptr)
-        state->midiChannel = upperChanAssigner->findMidiChannelForNewNote(keyLookup.notes[0]);
+void MidiGenerator::createNoteOn(ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer) {
+    int stolenKeyIndex = MPEChannelAllocator::NO_KEY;
+    if (keyLookup.output == MidiChannelType::MPE_Low)
+        state->midiChannel = lowerChanAllocator.noteOn(keyIndex, stolenKeyIndex);
+    else if (keyLookup.output == MidiChannelType::MPE_High)
+        state->midiChannel = upperChanAllocator.noteOn(keyIndex, stolenKeyIndex);
     else
         state->midiChannel = (int)keyLookup.output;
+    if (stolenKeyIndex != MPEChannelAllocator::NO_KEY)
+        releaseStolenKey(stolenKeyIndex, buffer);
     if (state->midiChannel > 0)
-        chanNotePri[state->midiChannel-1].push_front(keyLookup.keyId);
+        chanNotePri[state->midiChannel-1].push_front(keyIndex);
 
-    createNoteHold(keyLookup, state, buffer);
+    createNoteHold(keyLookup, state, keyIndex, buffer);
     auto vel = calculateNoteOnVelocity(state);
     int eventTime = buffer.getLastEventTime()+8;
     for (int i = 0; i < 4; i++) {
@@ -224,21 +391,14 @@ void MidiGenerator::createNoteOn(ConfigLookup::Key &keyLookup, KeyState *state,
     state->status = KeyStatus::Active;
 }
 
-void MidiGenerator::createNoteOff(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer) {
+void MidiGenerator::createNoteOff(ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer) {
     int channel = state->midiChannel;
-    if (keyLookup.output == MidiChannelType::MPE_Low && lowerChanAssigner != nullptr)
-        lowerChanAssigner->noteOff(keyLookup.notes[0], channel);
-    else if (keyLookup.output == MidiChannelType::MPE_High && upperChanAssigner != nullptr)
-        upperChanAssigner->noteOff(keyLookup.notes[0], channel);
-
-    if (state->midiChannel > 0) {
-        for (auto it = chanNotePri[state->midiChannel-1].begin(); it != chanNotePri[state->midiChannel-1].end(); it++) {
-            if (it->equals(keyLookup.keyId)) {
-                chanNotePri[state->midiChannel-1].erase(it);
-                break;
-            }
-        }
-    }
+    if (keyLookup.output == MidiChannelType::MPE_Low)
+        lowerChanAllocator.noteOff(keyIndex);
+    else if (keyLookup.output == MidiChannelType::MPE_High)
+        upperChanAllocator.noteOff(keyIndex);
+
+    removeFromChanNotePri(channel, keyIndex);
 
     int eventTime = buffer.getLastEventTime()+8;
     for (int i = 0; i < 4; i++) {
@@ -246,7 +406,8 @@ void MidiGenerator::createNoteOff(ConfigLookup::Key &keyLookup, KeyState *state,
             int matchingNotes = countPlayingNoteMatches(channel, keyLookup.notes[i]);
 
             if (matchingNotes < 2) {
-                auto noteOffMsg = juce::MidiMessage::noteOff(channel, keyLookup.notes[i], calculateNoteOffVelocity(state).asUnsignedFloat());
+                auto offVel = calculateNoteOffVelocity(state);
+                auto noteOffMsg = juce::MidiMessage::noteOff(channel, keyLookup.notes[i], offVel.asUnsignedFloat());
                 buffer.addEvent(noteOffMsg, eventTime);
             }
             removeOneNoteMatch(channel, keyLookup.notes[i]);
@@ -262,6 +423,34 @@ void MidiGenerator::createNoteOff(ConfigLookup::Key &keyLookup, KeyState *state,
     state->messageCount = 0;
 }
 
+void MidiGenerator::releaseStolenKey(int keyIndex, juce::MidiBuffer &buffer) {
+    KeyState *state = &getKeyState(keyIndex);
+    ConfigLookup::Key &keyLookup = getKeyLookup(keyIndex);
+
+    removeFromChanNotePri(state->midiChannel, keyIndex);
+    int eventTime = buffer.getLastEventTime()+8;
+    for (int i = 0; i < 4; i++) {
+        if (keyLookup.notes[i] > -1) {
+            if (countPlayingNoteMatches(state->midiChannel, keyLookup.notes[i]) < 2)
+                buffer.addEvent(juce::MidiMessage::noteOff(state->midiChannel, keyLookup.notes[i], calculateNoteOffVelocity(state).asUnsignedFloat()), eventTime);
+            removeOneNoteMatch(state->midiChannel, keyLookup.notes[i]);
+        }
+    }
+    state->status = KeyStatus::Stolen;
+}
+
+void MidiGenerator::removeFromChanNotePri(int channel, int keyIndex) {
+    if (channel < 1 || channel > 16)
+        return;
+
+    for (auto it = chanNotePri[channel-1].begin(); it != chanNotePri[channel-1].end(); it++) {
+        if (*it == keyIndex) {
+            chanNotePri[channel-1].erase(it);
+            break;
+        }
+    }
+}
+
 int MidiGenerator::countPlayingNoteMatches(int channel, int noteNumber) {
     int matchingNotes = 0;
     std::list<MidiNote>::iterator it = playingNotes.begin();
@@ -332,11 +521,17 @@ void MidiGenerator::createAllNotesOff(ConfigLookup::Key &keyLookup, KeyState *st
         buffer.addEvent(juce::MidiMessage::allNotesOff(i), buffer.getLastEventTime()+8);
         chanNotePri[i-1].clear();
     }
-    if (lowerChanAssigner != nullptr)
-        lowerChanAssigner->allNotesOff();
-    if (upperChanAssigner != nullptr)
-        upperChanAssigner->allNotesOff();
+    lowerChanAllocator.allNotesOff();
+    upperChanAllocator.allNotesOff();
     playingNotes.clear();
+    
+    // keys still held lost their notes, keep them silent until they are released
+    activeKeys.forEach([this](int keyIndex) {
+        auto &state = getKeyState(keyIndex);
+        auto mapType = getKeyLookup(keyIndex).mapType;
+        if (state.status == KeyStatus::Active && (mapType == KeyMappingType::Note || mapType == KeyMappingType::Chord))
+            state.status = KeyStatus::Stolen;
+    });
 }
 
 void MidiGenerator::createMidiMsgOff(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer, OSC::Message &outgoingOscMsg) {
@@ -374,12 +569,12 @@ void MidiGenerator::createMidiMsgOff(ConfigLookup::Key &keyLookup, KeyState *sta
     }
 }
 
-void MidiGenerator::createNoteHold(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer) {
+void MidiGenerator::createNoteHold(ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer) {
     int channel = state->midiChannel;
-    if (state->midiChannel > 0 && (chanNotePri[state->midiChannel-1].empty() || chanNotePri[state->midiChannel-1].front().equals(keyLookup.keyId))) {
+    if (state->midiChannel > 0 && (chanNotePri[state->midiChannel-1].empty() || chanNotePri[state->midiChannel-1].front() == keyIndex)) {
         addMidiValueMessage(channel, state->ehRoll, keyLookup.roll, keyLookup.pbRange, keyLookup.notes[0], buffer, true);
         addMidiValueMessage(channel, state->ehYaw, keyLookup.yaw, keyLookup.pbRange, keyLookup.notes[0], buffer, true);
-        addMidiValueMessage(channel, state->ehPressureHistory.back(), keyLookup.pressure, keyLookup.pbRange, keyLookup.notes[0], buffer, false);
+        addMidiValueMessage(channel, state->getLatestPressure(), keyLookup.pressure, keyLookup.pbRange, keyLookup.notes[0], buffer, false);
     }
     state->messageCount = 0;
 }
@@ -403,14 +598,60 @@ void MidiGenerator::addMidiValueMessage(int channel, int ehValue, ZoneWrapper::M
             msg = juce::MidiMessage::aftertouchChange(channel, noteNo, at.as7BitInt());
         }
         else if (midiValue.valueType == MidiValueType::CC) {
-            auto cc = isBipolar ? juce::MPEValue::from7BitInt(bipolar(ehValue*1.7f)*63+64)
-                                : juce::MPEValue::from7BitInt(unipolar(ehValue)*127);
-            msg = juce::MidiMessage::controllerEvent(channel, midiValue.ccNo, cc.as7BitInt());
+            addCCMessage(channel, ehValue, midiValue, buffer, isBipolar);
+            return;
         }
         buffer.addEvent(msg, buffer.getLastEventTime()+8);
     }
 }
 
+void MidiGenerator::addCCMessage(int channel, int ehValue, ZoneWrapper::MidiValue midiValue, juce::MidiBuffer &buffer, bool isBipolar) {
+    if (!midiValue.highRes || midiValue.ccNo > 31) {
+        auto cc = isBipolar ? juce::MPEValue::from7BitInt(bipolar(ehValue*1.7f)*63+64)
+                            : juce::MPEValue::from7BitInt(unipolar(ehValue)*127);
+        buffer.addEvent(juce::MidiMessage::controllerEvent(channel, midiValue.ccNo, cc.as7BitInt()), buffer.getLastEventTime()+8);
+        return;
+    }
+
+    auto cc = isBipolar ? juce::MPEValue::from14BitInt(bipolar(ehValue*1.7f)*8191+8192)
+                        : juce::MPEValue::from14BitInt(unipolar(ehValue)*16383);
+    int msb = cc.as14BitInt() >> 7;
+    int lsb = cc.as14BitInt() & 0x7f;
+    int &lastMSB = lastHighResMSB[channel-1][midiValue.ccNo];
+    int &lastLSB = lastHighResLSB[channel-1][midiValue.ccNo];
+    // receivers reset the LSB when the MSB arrives, so a new MSB is always followed by its LSB
+    if (msb != lastMSB) {
+        buffer.addEvent(juce::MidiMessage::controllerEvent(channel, midiValue.ccNo, msb), buffer.getLastEventTime()+8);
+        buffer.addEvent(juce::MidiMessage::controllerEvent(channel, midiValue.ccNo+32, lsb), buffer.getLastEventTime()+8);
+    }
+    else if (lsb != lastLSB) {
+        buffer.addEvent(juce::MidiMessage::controllerEvent(channel, midiValue.ccNo+32, lsb), buffer.getLastEventTime()+8);
+    }
+    lastMSB = msb;
+    lastLSB = lsb;
+}
+
+void MidiGenerator::resetHighResCCs(MidiChannelType output) {
+    int firstChannel = (int)output;
+    int lastChannel = (int)output;
+    if (output == MidiChannelType::MPE_Low || output == MidiChannelType::MPE_High) {
+        auto zone = output == MidiChannelType::MPE_Low ? mpeZone.getLowerZone() : mpeZone.getUpperZone();
+        if (!zone.isActive())
+            return;
+        firstChannel = std::min(zone.getMasterChannel(), zone.getLastMemberChannel());
+        lastChannel = std::max(zone.getMasterChannel(), zone.getLastMemberChannel());
+    }
+    if (firstChannel < 1 || lastChannel > 16)
+        return;
+
+    for (int i = firstChannel-1; i < lastChannel; i++) {
+        for (int j = 0; j < 32; j++) {
+            lastHighResMSB[i][j] = -1;
+            lastHighResLSB[i][j] = -1;
+        }
+    }
+}
+
 void MidiGenerator::addStripValueMessage(int channel, int ehValue, ZoneWrapper::MidiValue midiValue, juce::MidiBuffer &buffer, bool isBipolar) {
     if (midiValue.valueType != MidiValueType::Off) {
         juce::MidiMessage msg;
@@ -425,19 +666,60 @@ void MidiGenerator::addStripValueMessage(int channel, int ehValue, ZoneWrapper::
             msg = juce::MidiMessage::channelPressureChange(channel, at.as7BitInt());
         }
         else if (midiValue.valueType == MidiValueType::CC) {
-            auto cc = isBipolar ? juce::MPEValue::from7BitInt(bipolar(ehValue*1.7f)*63+64)
-                                : juce::MPEValue::from7BitInt(unipolar(ehValue)*127);
-            msg = juce::MidiMessage::controllerEvent(channel, midiValue.ccNo, cc.as7BitInt());
+            addCCMessage(channel, ehValue, midiValue, buffer, isBipolar);
+            return;
         }
         buffer.addEvent(msg, buffer.getLastEventTime()+8);
     }
 }
 
 
-void MidiGenerator::createLayoutRPNs(juce::MidiBuffer &buffer) {
-    buffer.clear();
-    auto buff = juce::MPEMessages::setZoneLayout(mpeZone);
-    buffer.addEvents(buffer, 0, -1, 0);
+void MidiGenerator::createLayoutRPNs(juce::AudioProcessorValueTreeState &pluginState) {
+    juce::MidiBuffer rpns = juce::MPEMessages::setZoneLayout(mpeZone);
+
+    // Not every synth spreads the zone pitchbend range to all member channels, so send it to each of them
+    bool isMPEChannel[16] = {};
+    auto addZoneChannelRPNs = [&](const juce::MPEZoneLayout::Zone &zone) {
+        if (!zone.isActive())
+            return;
+        isMPEChannel[zone.getMasterChannel()-1] = true;
+        int direction = zone.isLowerZone() ? 1 : -1;
+        for (int i = 0; i < zone.numMemberChannels; i++) {
+            int channel = zone.getFirstMemberChannel() + i*direction;
+            isMPEChannel[channel-1] = true;
+            rpns.addEvents(juce::MidiRPNGenerator::generate(channel, 0, zone.perNotePitchbendRange, false, false), 0, -1, 0);
+        }
+    };
+    addZoneChannelRPNs(mpeZone.getLowerZone());
+    addZoneChannelRPNs(mpeZone.getUpperZone());
+
+    // Zones on a fixed channel get the zone's max pitchbend as the channel range
+    const DeviceType deviceTypes[3] = { DeviceType::Alpha, DeviceType::Tau, DeviceType::Pico };
+    for (auto deviceType : deviceTypes) {
+        for (int z = 1; z <= 3; z++) {
+            Zone zone = (Zone)z;
+            if (!ZoneWrapper::getEnabled(deviceType, zone, pluginState.state))
+                continue;
+            int channel = (int)ZoneWrapper::getMidiChannelType(deviceType, zone, pluginState.state);
+            if (channel < 1 || channel > 16 || isMPEChannel[channel-1])
+                continue;
+            int pbRange = ZoneWrapper::getChannelMaxPitchbend(deviceType, zone, pluginState.state);
+            rpns.addEvents(juce::MidiRPNGenerator::generate(channel, 0, pbRange, false, false), 0, -1, 0);
+        }
+    }
+
+    const juce::SpinLock::ScopedLockType lock(layoutRPNLock);
+    layoutRPNBuffer.swapWith(rpns);
+    layoutRPNsPending = true;
+}
+
+void MidiGenerator::addLayoutRPNs(juce::MidiBuffer &buffer) {
+    const juce::SpinLock::ScopedTryLockType lock(layoutRPNLock);
+    if (!lock.isLocked() || !layoutRPNsPending)
+        return;
+
+    buffer.addEvents(layoutRPNBuffer, 0, -1, 0);
+    layoutRPNsPending = false;
 }
 
 float MidiGenerator::calculatePitchBendCurve(float value) {
@@ -445,27 +727,22 @@ float MidiGenerator::calculatePitchBendCurve(float value) {
 }
 
 juce::MPEValue MidiGenerator::calculateNoteOnVelocity(KeyState *state) {
-    if (state->ehPressureHistory.size() < PRESSURE_HISTORY_LENGTH)
+    if (state->pressureCount < PRESSURE_HISTORY_LENGTH)
         return juce::MPEValue::from7BitInt(1);
     
-    auto listPos = state->ehPressureHistory.begin();
-    std::advance(listPos, 1);
-    unsigned int val1 = (*listPos)*0.5;
-    std::advance(listPos, 1);
-    val1 += (*listPos)*0.5;
-    std::advance(listPos, 2);
-    unsigned int val2 = (*listPos)*0.5;
-    std::advance(listPos, 1);
-    val2 += (*listPos)*0.5;
+    unsigned int val1 = state->getPressure(1)*0.5;
+    val1 += state->getPressure(2)*0.5;
+    unsigned int val2 = state->getPressure(4)*0.5;
+    val2 += state->getPressure(5)*0.5;
     int tableIndex = (val2 - val1);
     tableIndex = std::max(0, std::min(velocityCurve.TABLE_LENGTH-1, tableIndex));
     return juce::MPEValue::from7BitInt(velocityCurve.getTableValue(tableIndex)*126+1);
 }
 
 juce::MPEValue MidiGenerator::calculateNoteOffVelocity(KeyState *state) {
-    if (state->ehPressureHistory.size() < PRESSURE_HISTORY_LENGTH)
+    if (state->pressureCount < PRESSURE_HISTORY_LENGTH)
         return juce::MPEValue::from7BitInt(0);
     
-    unsigned int pressure = state->ehPressureHistory.front();
+    unsigned int pressure = state->getPressure(0);
     return juce::MPEValue::from7BitInt(unipolar(pressure*10.0f)*127);
 }
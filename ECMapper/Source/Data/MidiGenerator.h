@@ -4,6 +4,8 @@
 #include "ConfigLookup.h"
 #include "OSCMessageQueue.h"
 #include "BezierCurve.h"
+#include "MPEChannelAllocator.h"
+#include "ActiveKeySet.h"
 
 class MidiGenerator {
 public:
@@ -11,61 +13,128 @@ public:
     ~MidiGenerator();
     
     static const int PRESSURE_HISTORY_LENGTH = 6;
+    // A held key sends every scan, a note key without an update for this long lost its release on the way
+    static const int STUCK_KEY_TIMEOUT_MS = 2000;
 
     void processOSCMessage(OSC::Message &oscMsg, OSC::Message &outgoingOscMsg, juce::MidiBuffer &midiBuffer);
     void reduceBreath(juce::MidiBuffer &buffer);
+    // Releases note keys that timed out, once per block
+    void releaseStuckKeys(juce::MidiBuffer &buffer);
+    juce::int64 getStuckKeyCount() const { return stuckKeyCount.load(std::memory_order_relaxed); }
     juce::MPEZoneLayout mpeZone;
     
-    void createLayoutRPNs(juce::MidiBuffer &buffer);
+    void addLayoutRPNs(juce::MidiBuffer &buffer);
+    // Rebuilds the layout RPNs off the audio thread, the next block sends them
+    void createLayoutRPNs(juce::AudioProcessorValueTreeState &pluginState);
+    // Forgets the 14-bit CC pairs last sent on the channels of a zone output, so the next value sends both halves
+    void resetHighResCCs(MidiChannelType output);
     void start(juce::AudioProcessorValueTreeState &pluginState);
     void stop();
     bool initialized = false;
+    float getMPEChannelOccupancy() const;
+    int getMPEStealCount() const;
+    // Cross checks key states, playing notes, channel priorities and the MPE allocators. Only valid while the layout
+    // isn't changed under held keys, and far too slow for processBlock, it is meant for ecmapper_bench --stress.
+    bool checkInvariants(juce::String &problem) const;
     
 private:
-    enum KeyStatus {
+    enum KeyStatus : juce::uint8 {
         Off = 0,
         Pending = 1,
-        Active = 2
+        Active = 2,
+        Stolen = 3
     };
     
-    struct KeyState {
-        KeyStatus status = KeyStatus::Off;
-        std::list<unsigned int> ehPressureHistory;
-        int ehRoll = 0;
-        int ehYaw = 0;
-        
+    // 32 bytes, two keys to a cache line
+    struct alignas(32) KeyState {
+        juce::uint32 lastUpdate = 0; // juce::Time::getMillisecondCounter()
+        juce::uint16 ehPressureHistory[PRESSURE_HISTORY_LENGTH] = {}; // ring, see addPressure()
+        juce::int16 ehRoll = 0;
+        juce::int16 ehYaw = 0;
+        juce::uint16 messageCount = 0;
+        juce::uint8 pressureCount = 0;
+        juce::uint8 nextPressure = 0;
         int midiChannel = 1;
-        int messageCount = 0;
+        KeyStatus status = KeyStatus::Off;
         bool isLatchOn = false;
+        
+        void addPressure(unsigned int pressure) {
+            ehPressureHistory[nextPressure] = (juce::uint16)std::min(pressure, 0xffffu);
+            nextPressure = (nextPressure + 1) % PRESSURE_HISTORY_LENGTH;
+            if (pressureCount < PRESSURE_HISTORY_LENGTH)
+                pressureCount++;
+        }
+        // i = 0 is the oldest pressure kept
+        unsigned int getPressure(int i) const {
+            return ehPressureHistory[(nextPressure + PRESSURE_HISTORY_LENGTH - pressureCount + i) % PRESSURE_HISTORY_LENGTH];
+        }
+        unsigned int getLatestPressure() const { return pressureCount == 0 ? 0 : getPressure(pressureCount - 1); }
+    };
+    
+    // What processDeviceMessage() needs to know about a device type at compile time
+    template <int Type>
+    struct DeviceTraits {
+        static const int deviceIndex = Type - 1;
+        static const int strips = DeviceGeometry::devices[Type].strips;
+        // breath below this is the sensor at rest, the Pico's reads higher
+        static const unsigned int breathZeroThreshold = Type == (int)DeviceType::Pico ? 512 : 128;
+    };
+    
+    // Everything played on one instrument. Instruments of the same type share their layout and ConfigLookup.
+    struct InstrumentState {
+        InstrumentState(int deviceType) : keyStates(DeviceGeometry::keyCount(deviceType)) {}
+        std::vector<KeyState> keyStates; // by DeviceGeometry::keyIndex()
+        unsigned int ehBreath = 0;
+        int ehStrips[2] = { 0, 0 };
+        int relStart_ehStrips[2] = { -1, -1 };
     };
     
-    KeyState keyStates[3][3][120];
+    // per device type, indexed by OSC::Message::instance. All OSC::MaxInstances exist from the start, so nothing
+    // is allocated on the audio thread when another instrument shows up.
+    std::vector<std::unique_ptr<InstrumentState>> instruments[3];
+    InstrumentState* getInstrument(int deviceIndex, int instance);
+    KeyState& getKeyState(int keyIndex);
+    ConfigLookup::Key& getKeyLookup(int keyIndex);
+    
+    // every key whose status is not Off
+    ActiveKeySet activeKeys;
+    std::atomic<juce::int64> stuckKeyCount { 0 };
     
-    unsigned int ehBreath[3] = { 0,0,0 };
     unsigned int ehPedal1 = 0;
     unsigned int ehPedal2 = 0;
-    int ehStrips[2][3] = {{ 0, 0, 0 }, { 0, 0, 0 }};
-    int relStart_ehStrips[2][3] = {{ -1, -1, -1 }, { -1, -1, -1 }};
     int currentKeyPBperChannel[16];
     int currentStripPBperChannel[16];
+    int lastHighResMSB[16][32];
+    int lastHighResLSB[16][32];
     
-    juce::MPEChannelAssigner *lowerChanAssigner = nullptr;
-    juce::MPEChannelAssigner *upperChanAssigner = nullptr;
+    MPEChannelAllocator lowerChanAllocator;
+    MPEChannelAllocator upperChanAllocator;
     
-    void processNoteKey(OSC::Message &oscMsg, ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer);
+    // processOSCMessage() dispatches every message once to the instantiation for its device type
+    template <int Type>
+    void processDeviceMessage(OSC::Message &oscMsg, OSC::Message &outgoingOscMsg, juce::MidiBuffer &midiBuffer);
+    void processNoteKey(OSC::Message &oscMsg, ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer);
     void processCmdKey(OSC::Message &oscMsg, OSC::Message &outgoingOscMsg, ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer);
-    void createNoteOn(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer);
-    void createNoteOff(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer);
-    void createNoteHold(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer);
+    void createNoteOn(ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer);
+    void createNoteOff(ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer);
+    void releaseStolenKey(int keyIndex, juce::MidiBuffer &buffer);
+    void removeFromChanNotePri(int channel, int keyIndex);
+    void createNoteHold(ConfigLookup::Key &keyLookup, KeyState *state, int keyIndex, juce::MidiBuffer &buffer);
     void createMidiMsgOn(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer, OSC::Message &outgoingOscMsg);
     void createMidiMsgOff(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer, OSC::Message &outgoingOscMsg);
     void addMidiValueMessage(int channel, int ehValue, ZoneWrapper::MidiValue midiValue, float pbRange, int noteNo, juce::MidiBuffer &buffer, bool isBipolar);
     void addStripValueMessage(int channel, int ehValue, ZoneWrapper::MidiValue midiValue, juce::MidiBuffer &buffer, bool isBipolar);
-    void createBreath(int deviceIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer);
-    void createStripAbsolute(int deviceIndex, int stripIndex, int zoneIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer);
-    void createStripRelative(int deviceIndex, int stripIndex, int zoneIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer);
+    void addCCMessage(int channel, int ehValue, ZoneWrapper::MidiValue midiValue, juce::MidiBuffer &buffer, bool isBipolar);
+    void createBreath(unsigned int zeroThreshold, InstrumentState &instrument, ConfigLookup &keyLookup, juce::MidiBuffer &buffer);
+    void createStripAbsolute(InstrumentState &instrument, int stripIndex, int zoneIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer);
+    void createStripRelative(InstrumentState &instrument, int stripIndex, int zoneIndex, ConfigLookup &keyLookup, juce::MidiBuffer &buffer);
     void createAllNotesOff(ConfigLookup::Key &keyLookup, KeyState *state, juce::MidiBuffer &buffer, OSC::Message &outgoingOscMsg);
     
+    // every key of every instrument, instruments of all three types packed back to back per instance
+    inline int getKeyIndex(int deviceIndex, int instance, int index) const { return instance*DeviceGeometry::AllKeys + DeviceGeometry::offset(deviceIndex + 1) + index; }
+    inline int getKeyInstance(int keyIndex) const { return keyIndex/DeviceGeometry::AllKeys; }
+    inline int getKeyDeviceIndex(int keyIndex) const { return DeviceGeometry::deviceTypeAt(keyIndex%DeviceGeometry::AllKeys) - 1; }
+    inline int getKeyFlatIndex(int keyIndex) const { return keyIndex%DeviceGeometry::AllKeys - DeviceGeometry::offset(getKeyDeviceIndex(keyIndex) + 1); }
     inline float clamp(float v, float mn, float mx) { return (std::max(std::min(v, mx), mn)); }
     float unipolar(int val) { return std::min(float(val) / 4096.0f, 1.0f); }
     float bipolar(int val) { return clamp(float(val) / 4096.0f, -1.0f, 1.0f); }
@@ -75,11 +144,17 @@ private:
     
     ConfigLookup *configLookups;
     int stripMessageCount[2] = { 0, 0 };
-    const int breathZeroThreshold[3] = {128, 128, 512};
+    const unsigned int breathZeroThreshold[3] = { DeviceTraits<1>::breathZeroThreshold, DeviceTraits<2>::breathZeroThreshold, DeviceTraits<3>::breathZeroThreshold };
+
+    // MPE zone layout and pitchbend range RPNs, serialised in start() and on zone channel or pitchbend changes,
+    // copied out by the audio thread
+    juce::MidiBuffer layoutRPNBuffer;
+    bool layoutRPNsPending = false;
+    juce::SpinLock layoutRPNLock;
     
     BezierCurve velocityCurve;
     
-    std::list<LayoutWrapper::KeyId> chanNotePri[16];
+    std::list<int> chanNotePri[16]; // key indexes, see getKeyIndex()
     
     struct MidiNote {
         int channnel;
@@ -1,18 +1,21 @@
 #include "OSCCommunication.h"
 
-static int receiverListenerCount = 0;
-static juce::OSCReceiver *receiver = nullptr;
-static bool receiverIsConnected = false;
+// Shared by all instances in the process: whoever polls first hands the messages to every listening instance
+static LocalLink::Consumer localLink;
+static juce::SpinLock localLinkLock;
+static juce::Array<OSCCommunication*> localLinkListeners;
 
-OSCCommunication::OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue, ECMLogger *logger) {
+OSCCommunication::OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue, ECMLogger *logger, LatencyTrace *latencyTrace, Metrics::Registry &metrics)
+    : messagesReceived(metrics.addCounter("osc_received")), messagesRejected(metrics.addCounter("osc_rejected")), pingTimeouts(metrics.addCounter("ping_timeouts")), localReceived(metrics.addCounter("local_received")), echoProbe(metrics) {
     this->logger = logger;
-    if (receiver == nullptr)
-        receiver = new juce::OSCReceiver();
+    this->latencyTrace = latencyTrace;
     this->sendQueue = sendQueue;
     this->receiveQueue = receiveQueue;
-    receiver->registerFormatErrorHandler([this](const char *data, int dataSize) {
+    receiver.registerFormatErrorHandler([this](const char *data, int dataSize) {
         std::cout << "invalid OSC data" << std::endl;
     });
+    metrics.addGauge("local_link", [this] { return (juce::int64)isLocalLinkAttached(); });
+    metrics.addGauge("local_dropped", [this] { return getLocalLinkDroppedCount(); });
     
     startTimer(pingInterval);
 }
@@ -21,10 +24,6 @@ OSCCommunication::~OSCCommunication() {
     stopTimer();
     disconnectSender();
     disconnectReceiver();
-    if (receiverListenerCount == 0 && receiver != nullptr) {
-        delete receiver;
-        receiver = nullptr;
-    }
 }
 
 bool OSCCommunication::connectSender() {
@@ -40,129 +39,127 @@ void OSCCommunication::disconnectSender() {
 }
 
 bool OSCCommunication::connectReceiver() {
-    if (!receiverIsConnected)
-        receiverIsConnected = receiver->connect(receiverPort);
-    if (!isListeningToReceiver && receiverIsConnected) {
-        receiver->addListener(this);
-        receiverListenerCount++;
-        isListeningToReceiver = true;
+    // Every instance listens on a port of its own, the first free one from receiverPort on,
+    // and subscribes to EigenCore with it in its pings
+    for (int i = 0; i < RECEIVER_PORT_COUNT && !isListeningToReceiver; i++) {
+        if (receiver.connect(receiverPort + i)) {
+            listeningPort = receiverPort + i;
+            receiver.addListener(this);
+            isListeningToReceiver = true;
+            const juce::SpinLock::ScopedLockType lock(localLinkLock);
+            localLinkListeners.add(this);
+        }
     }
-    logger->log("ConnectReceiver called: receiverIsConnected is now: " + juce::String((int)receiverIsConnected));
-    logger->log("ReceiverListening count is now: " + juce::String(receiverListenerCount));
-    return receiverIsConnected;
+    logger->log("ConnectReceiver called: listening on port " + juce::String(listeningPort));
+    return isListeningToReceiver;
 }
 
 void OSCCommunication::disconnectReceiver() {
     if (isListeningToReceiver) {
-        receiver->removeListener(this);
-        receiverListenerCount--;
+        receiver.removeListener(this);
+        receiver.disconnect();
         isListeningToReceiver = false;
+        listeningPort = -1;
+        const juce::SpinLock::ScopedLockType lock(localLinkLock);
+        localLinkListeners.removeFirstMatchingValue(this);
+        if (localLinkListeners.isEmpty())
+            localLink.detach();
     }
-    if (receiverListenerCount == 0) {
-        receiver->disconnect();
-        receiverIsConnected = false;
-    }
-    logger->log("DisconnectReceiver called: receiverIsConnected is now: " + juce::String((int)receiverIsConnected));
-    logger->log("ReceiverListening count is now: " + juce::String(receiverListenerCount));
+    logger->log("DisconnectReceiver called: isListeningToReceiver is now: " + juce::String((int)isListeningToReceiver));
 }
 
 void OSCCommunication::oscMessageReceived(const juce::OSCMessage &message) {
-    if (message.getAddressPattern() == "/EigenCore/ping") {
+    messagesReceived.add();
+    auto receiveTime = LatencyTrace::nowMicros();
+    auto decodeResult = OSCDecoder::decode(message, msg);
+    if (decodeResult == OSCDecoder::Result::Decoded) {
+        if (msg.type == OSC::MessageType::Key && msg.sendTime != 0) {
+            msg.callbackTime = echoProbe.toLocalTime(msg.callbackTime);
+            msg.sendTime = echoProbe.toLocalTime(msg.sendTime);
+            msg.receiveTime = receiveTime;
+            latencyTrace->record(LatencyTrace::SendToReceive, msg.sendTime, msg.receiveTime);
+        }
+        receiveQueue->add(&msg);
+    }
+    else if (decodeResult == OSCDecoder::Result::Rejected) {
+        messagesRejected.add();
+    }
+    else if (message.getAddressPattern() == "/EigenCore/ping") {
         if (pingCounter == -1) {
             logger->log("Core connected.");
             eigenCoreConnected = true;
+            // a restarted EigenCore knows nothing about this instance's subscriptions
+            subscriptionCounter = SUBSCRIPTION_RESEND_PINGS;
         }
         pingCounter = 0;
+        // EigenCore versions with the local link send their process id, attaching only works on the same machine
+        if (message.size() == 1 && message[0].isInt32()) {
+            const juce::SpinLock::ScopedLockType lock(localLinkLock);
+            if (isListeningToReceiver && !localLink.isAttached() && localLink.attach(receiverPort, message[0].getInt32()))
+                logger->log("EigenCore runs on this machine, attached to the local link.");
+        }
 //        receiveQueue->add(&msg);
 
     }
-    else if (message.getAddressPattern() == "/EigenCore/key" && message.size() == 7) {
-        msg = {
-            .type = OSC::MessageType::Key,
-            .course = (unsigned int)message[0].getInt32(),
-            .key = (unsigned int)message[1].getInt32(),
-            .active = message[2].getInt32(),
-            .pressure = (unsigned int)message[3].getInt32(),
-            .roll = message[4].getInt32(),
-            .yaw = message[5].getInt32(),
-            .strip = 0,
-            .pedal = 0,
-            .value = 0,
-            .device = (DeviceType)message[6].getInt32()
-        };
-        receiveQueue->add(&msg);
-    }
-    else if (message.getAddressPattern() == "/EigenCore/breath" && message.size() == 2) {
-        msg = {
-            .type = OSC::MessageType::Breath,
-            .course = 0,
-            .key = 0,
-            .active = 0,
-            .pressure = 0,
-            .roll = 0,
-            .yaw = 0,
-            .strip = 0,
-            .pedal = 0,
-            .value = (unsigned int)message[0].getInt32(),
-            .device = (DeviceType)message[1].getInt32()
-        };
-        receiveQueue->add(&msg);
+    else if (message.getAddressPattern() == "/EigenCore/probe" && message.size() == 2 && message[0].isInt32() && message[1].isInt32()) {
+        if (senderIsConnected)
+            sender.send("/ECMapper/probeReply", message[0].getInt32(), message[1].getInt32(), (int)receiveTime, (int)LatencyTrace::nowMicros());
     }
-    else if (message.getAddressPattern() == "/EigenCore/strip" && message.size() == 4) {
-        msg = {
-            .type = OSC::MessageType::Strip,
-            .course = 0,
-            .key = 0,
-            .active = message[2].getInt32(),
-            .pressure = 0,
-            .roll = 0,
-            .yaw = 0,
-            .strip = (unsigned int)message[0].getInt32(),
-            .pedal = 0,
-            .value = (unsigned int)message[1].getInt32(),
-            .device = (DeviceType)message[3].getInt32()
-        };
-        receiveQueue->add(&msg);
+    else if (message.getAddressPattern() == "/EigenCore/probeReply" && message.size() == 4
+             && message[0].isInt32() && message[1].isInt32() && message[2].isInt32() && message[3].isInt32()) {
+        echoProbe.replyReceived(message[0].getInt32(), (juce::uint32)message[1].getInt32(), (juce::uint32)message[2].getInt32(), (juce::uint32)message[3].getInt32(), receiveTime);
     }
-    else if (message.getAddressPattern() == "/EigenCore/pedal" && message.size() == 3) {
-        msg = {
-            .type = OSC::MessageType::Pedal,
-            .course = 0,
-            .key = 0,
-            .active = 0,
-            .pressure = 0,
-            .roll = 0,
-            .yaw = 0,
-            .strip = 0,
-            .pedal = (unsigned int)message[0].getInt32(),
-            .value = (unsigned int)message[1].getInt32(),
-            .device = (DeviceType)message[2].getInt32()
-        };
-        receiveQueue->add(&msg);
+}
+
+void OSCCommunication::pollLocalLink() {
+    // another instance may be polling on its own audio thread, it delivers to this one as well
+    const juce::SpinLock::ScopedTryLockType lock(localLinkLock);
+    if (!lock.isLocked() || !localLink.isAttached())
+        return;
+    
+    LocalLink::Record record;
+    OSC::Message message;
+    auto receiveTime = LatencyTrace::nowMicros();
+    while (localLink.pop(record)) {
+        if (OSCDecoder::decode(record, message) != OSCDecoder::Result::Decoded) {
+            messagesRejected.add();
+            continue;
+        }
+        message.receiveTime = message.sendTime == 0 ? 0 : receiveTime;
+        for (auto listener : localLinkListeners) {
+            if (!(listener->subscribedDevices.load(std::memory_order_relaxed) & (1 << (int)message.device)))
+                continue;
+            if (message.receiveTime != 0)
+                listener->latencyTrace->record(LatencyTrace::SendToReceive, message.sendTime, message.receiveTime);
+            listener->localReceived.add();
+            listener->localReceiveQueue.add(&message);
+        }
     }
-    else if (message.getAddressPattern() == "/EigenCore/device" && message.size() == 1) {
-        msg = {
-            .type = OSC::MessageType::Device,
-            .course = 0,
-            .key = 0,
-            .active = 0,
-            .pressure = 0,
-            .roll = 0,
-            .yaw = 0,
-            .strip = 0,
-            .pedal = 0,
-            .value = 0,
-            .device = (DeviceType)message[0].getInt32()
-        };
-        receiveQueue->add(&msg);
+    
+    if (!localLink.isProducerOpen()) {
+        logger->log("EigenCore closed the local link.");
+        localLink.detach();
     }
 }
 
-void OSCCommunication::sendLED(int course, int key, int led, DeviceType deviceType) {
+bool OSCCommunication::isLocalLinkAttached() const {
+    return isListeningToReceiver && localLink.isAttached();
+}
+
+juce::int64 OSCCommunication::getLocalLinkDroppedCount() const {
+    const juce::SpinLock::ScopedLockType lock(localLinkLock);
+    return isLocalLinkAttached() ? localLink.getDroppedCount() : 0;
+}
+
+void OSCCommunication::sendLED(int course, int key, int led, DeviceType deviceType, int instance) {
     if (!senderIsConnected)
         return;
-        
-    sender.send("/ECMapper/led", course, key, led, (int)deviceType);
+    
+    // without an instance EigenCore lights the key on every instrument of the type
+    if (instance == OSC::AllInstances)
+        sender.send("/ECMapper/led", course, key, led, (int)deviceType);
+    else
+        sender.send("/ECMapper/led", course, key, led, (int)deviceType, instance);
 }
 
 void OSCCommunication::sendReset(DeviceType deviceType) {
@@ -173,13 +170,23 @@ void OSCCommunication::sendReset(DeviceType deviceType) {
 }
 
 void OSCCommunication::timerCallback() {
-    if (senderIsConnected)
-        sender.send("/ECMapper/ping");
+    if (getSubscribedDevices)
+        subscribedDevices = getSubscribedDevices();
+    // without a port of our own, a ping would subscribe whoever listens on the configured one
+    if (senderIsConnected && isListeningToReceiver) {
+        sender.send("/ECMapper/ping", listeningPort, LocalLink::currentProcessId(), subscribedDevices.load());
+        if (eigenCoreConnected) {
+            auto sentTime = LatencyTrace::nowMicros();
+            sender.send("/ECMapper/probe", echoProbe.prepareProbe(sentTime), (int)sentTime, listeningPort);
+            sendSubscriptions();
+        }
+    }
     if (pingCounter > -1)
         pingCounter++;
     
     if (pingCounter > 10) {
-        logger->log("Connection to Core timed out");
+        logger->log("Connection to Core timed out", ECMLogger::Level::Warning);
+        pingTimeouts.add();
         pingCounter = -1;
         eigenCoreConnected = false;
     }
@@ -187,16 +194,39 @@ void OSCCommunication::timerCallback() {
     sendOutgoingMessages();
 }
 
+void OSCCommunication::sendSubscriptions() {
+    if (!getSubscription)
+        return;
+    
+    // on change, and now and then in case EigenCore lost one
+    bool resend = ++subscriptionCounter >= SUBSCRIPTION_RESEND_PINGS;
+    if (resend)
+        subscriptionCounter = 0;
+    for (auto deviceType : { DeviceType::Alpha, DeviceType::Tau, DeviceType::Pico }) {
+        auto filter = getSubscription(deviceType);
+        auto &sent = sentSubscriptions[(int)deviceType - 1];
+        if (!resend && filter == sent)
+            continue;
+        
+        juce::OSCMessage message("/ECMapper/subscribe");
+        message.addInt32(listeningPort);
+        message.addInt32((int)deviceType);
+        filter.addTo(message);
+        if (sender.send(message))
+            sent = filter;
+    }
+}
+
 void OSCCommunication::sendOutgoingMessages() {
     if (!senderIsConnected)
         return;
     
-    static OSC::Message msg;
+    OSC::Message msg;
     while (sendQueue->getMessageCount() > 0) {
         sendQueue->read(&msg);
         switch (msg.type) {
             case OSC::MessageType::LED:
-                sendLED(msg.course, msg.key, msg.value, msg.device);
+                sendLED(msg.course, msg.key, msg.value, msg.device, msg.instance);
                 break;
             case OSC::MessageType::Reset:
                 sendReset(msg.device);
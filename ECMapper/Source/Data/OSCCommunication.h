@@ -5,10 +5,18 @@
 #include "OSCMessageQueue.h"
 #include "../Models/Enums.h"
 #include "Logger.h"
+#include "LatencyTrace.h"
+#include "Metrics.h"
+#include "EchoProbe.h"
+#include "OSCDecoder.h"
+#include "Subscription.h"
+
+#define RECEIVER_PORT_COUNT 8 // EigenCore serves up to 8 subscribers
+#define SUBSCRIPTION_RESEND_PINGS 10
 
 class OSCCommunication : private juce::OSCReceiver::Listener<juce::OSCReceiver::MessageLoopCallback>, juce::Timer {
 public:
-    OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue, ECMLogger *logger);
+    OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue, ECMLogger *logger, LatencyTrace *latencyTrace, Metrics::Registry &metrics);
     ~OSCCommunication();
     bool connectSender();
     void disconnectSender();
@@ -18,25 +26,47 @@ public:
     bool isListeningToReceiver = false;
     bool eigenCoreConnected = false;
     
-    void sendLED(int course, int key, int led, DeviceType deviceType);
+    void sendLED(int course, int key, int led, DeviceType deviceType, int instance);
     void sendReset(DeviceType deviceType);
+    // Moves messages from the local link into localReceiveQueue of every listening instance, call from processBlock
+    void pollLocalLink();
+    bool isLocalLinkAttached() const;
+    // records EigenCore could not put into the attached ring, see LocalLink::Producer::send()
+    juce::int64 getLocalLinkDroppedCount() const;
     OSC::OSCMessageFifo *receiveQueue;
+    OSC::OSCMessageFifo localReceiveQueue;
     juce::String senderIP;
     int senderPort = -1;
-    int receiverPort = -1;
+    int receiverPort = -1;  // first port to try, see connectReceiver()
+    int listeningPort = -1;
+    // bit per DeviceType, sent to EigenCore with every ping so it only sends what this instance maps.
+    // Called on the message thread.
+    std::function<int()> getSubscribedDevices;
+    // what this instance maps on a device, see Subscription.h. Called on the message thread.
+    std::function<Subscription::DeviceFilter(DeviceType)> getSubscription;
 
 private:
     juce::OSCSender sender;
-//    juce::OSCReceiver receiver;
+    juce::OSCReceiver receiver;
+    std::atomic<int> subscribedDevices { ~0 };
     
     void oscMessageReceived(const juce::OSCMessage& message) override;
     void timerCallback() override;
     int pingCounter = -1;
     const int pingInterval = 100;
+    Subscription::DeviceFilter sentSubscriptions[3];
+    int subscriptionCounter = SUBSCRIPTION_RESEND_PINGS;
 
     OSC::OSCMessageFifo *sendQueue;
     OSC::Message msg;
     ECMLogger *logger;
+    LatencyTrace *latencyTrace;
+    Metrics::Counter &messagesReceived;
+    Metrics::Counter &messagesRejected;
+    Metrics::Counter &pingTimeouts;
+    Metrics::Counter &localReceived;
+    EchoProbe echoProbe;
     
     void sendOutgoingMessages();
+    void sendSubscriptions();
 };
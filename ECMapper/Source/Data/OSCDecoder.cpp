@@ -0,0 +1,141 @@
+#include "OSCDecoder.h"
+
+namespace OSCDecoder {
+
+static bool allInt32(const juce::OSCMessage &message) {
+    bool valid = true;
+    for (int i = 0; i < message.size(); i++)
+        valid &= message[i].isInt32();
+    return valid;
+}
+
+static inline bool inRange(int value, int low, int high) {
+    return (unsigned int)(value - low) <= (unsigned int)(high - low);
+}
+
+static inline bool isDevice(int value) {
+    return inRange(value, (int)DeviceType::Alpha, (int)DeviceType::Pico);
+}
+
+// EigenCore versions that tell instruments of the same type apart append the instance, older ones mean 0
+static inline bool readInstance(const juce::OSCMessage &message, int plainSize, OSC::Message &msg) {
+    if (message.size() == plainSize)
+        return true;
+    msg.instance = message[plainSize].getInt32();
+    return inRange(msg.instance, 0, OSC::MaxInstances - 1);
+}
+
+Result decode(const juce::OSCMessage &message, OSC::Message &msg) {
+    auto &address = message.getAddressPattern();
+    auto size = message.size();
+    msg = OSC::Message();
+    
+    if (address == "/EigenCore/key") {
+        if ((size != 7 && size != 9 && size != 10) || !allInt32(message) || !readInstance(message, size == 7 ? 7 : 9, msg))
+            return Result::Rejected;
+        int course = message[0].getInt32();
+        int key = message[1].getInt32();
+        int device = message[6].getInt32();
+        if (!(isDevice(device) & inRange(course, 0, 2) & inRange(key, 0, 119)))
+            return Result::Rejected;
+        
+        msg.type = OSC::MessageType::Key;
+        msg.course = (unsigned int)course;
+        msg.key = (unsigned int)key;
+        msg.active = message[2].getInt32() != 0;
+        msg.pressure = (unsigned int)message[3].getInt32();
+        msg.roll = message[4].getInt32();
+        msg.yaw = message[5].getInt32();
+        msg.device = (DeviceType)device;
+        // EigenCore versions with latency tracing append the callback and send timestamps
+        if (size >= 9) {
+            msg.callbackTime = (juce::uint32)message[7].getInt32();
+            msg.sendTime = (juce::uint32)message[8].getInt32();
+        }
+        return Result::Decoded;
+    }
+    else if (address == "/EigenCore/breath") {
+        if ((size != 2 && size != 3) || !allInt32(message) || !isDevice(message[1].getInt32()) || !readInstance(message, 2, msg))
+            return Result::Rejected;
+        msg.type = OSC::MessageType::Breath;
+        msg.value = (unsigned int)message[0].getInt32();
+        msg.device = (DeviceType)message[1].getInt32();
+        return Result::Decoded;
+    }
+    else if (address == "/EigenCore/strip") {
+        if ((size != 4 && size != 5) || !allInt32(message) || !(inRange(message[0].getInt32(), 1, 2) & isDevice(message[3].getInt32()))
+            || !readInstance(message, 4, msg))
+            return Result::Rejected;
+        msg.type = OSC::MessageType::Strip;
+        msg.strip = (unsigned int)message[0].getInt32();
+        msg.value = (unsigned int)message[1].getInt32();
+        msg.active = message[2].getInt32() != 0;
+        msg.device = (DeviceType)message[3].getInt32();
+        return Result::Decoded;
+    }
+    else if (address == "/EigenCore/pedal") {
+        if ((size != 3 && size != 4) || !allInt32(message) || !((message[0].getInt32() >= 0) & isDevice(message[2].getInt32()))
+            || !readInstance(message, 3, msg))
+            return Result::Rejected;
+        msg.type = OSC::MessageType::Pedal;
+        msg.pedal = (unsigned int)message[0].getInt32();
+        msg.value = (unsigned int)message[1].getInt32();
+        msg.device = (DeviceType)message[2].getInt32();
+        return Result::Decoded;
+    }
+    else if (address == "/EigenCore/device") {
+        if ((size != 1 && size != 2) || !allInt32(message) || !isDevice(message[0].getInt32()) || !readInstance(message, 1, msg))
+            return Result::Rejected;
+        msg.type = OSC::MessageType::Device;
+        msg.device = (DeviceType)message[0].getInt32();
+        return Result::Decoded;
+    }
+    return Result::Unknown;
+}
+
+Result decode(const LocalLink::Record &record, OSC::Message &msg) {
+    msg = OSC::Message();
+    if (!isDevice(record.device) || !inRange(record.instance, 0, OSC::MaxInstances - 1))
+        return Result::Rejected;
+    
+    switch (record.type) {
+        case OSC::MessageType::Key:
+            if (!(record.course <= 2 && record.key <= 119))
+                return Result::Rejected;
+            msg.course = record.course;
+            msg.key = record.key;
+            msg.active = record.active != 0;
+            msg.pressure = record.pressure;
+            msg.roll = record.roll;
+            msg.yaw = record.yaw;
+            msg.callbackTime = record.callbackTime;
+            msg.sendTime = record.sendTime;
+            break;
+        case OSC::MessageType::Breath:
+            msg.value = record.value;
+            break;
+        case OSC::MessageType::Strip:
+            if (!inRange((int)record.strip, 1, 2))
+                return Result::Rejected;
+            msg.strip = record.strip;
+            msg.value = record.value;
+            msg.active = record.active != 0;
+            break;
+        case OSC::MessageType::Pedal:
+            if ((int)record.pedal < 0)
+                return Result::Rejected;
+            msg.pedal = record.pedal;
+            msg.value = record.value;
+            break;
+        case OSC::MessageType::Device:
+            break;
+        default:
+            return Result::Rejected;
+    }
+    msg.type = (OSC::MessageType)record.type;
+    msg.device = (DeviceType)record.device;
+    msg.instance = record.instance;
+    return Result::Decoded;
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <JuceHeader.h>
+#include "OSCMessageQueue.h"
+#include "LocalLink.h"
+
+// Turns the EigenCore data messages into OSC::Message. Argument types and counts are checked, and every value
+// that is used as an array index further down (device, instance, course, key, strip) is range checked, so a malformed
+// or hostile packet is dropped here instead of reaching MidiGenerator.
+namespace OSCDecoder {
+
+enum class Result {
+    Decoded,
+    Rejected,   // known address, but wrong arguments or values out of range
+    Unknown     // not a data message, e.g. ping or probe
+};
+
+Result decode(const juce::OSCMessage &message, OSC::Message &msg);
+// Same checks for records taken from the local link, see LocalLink.h
+Result decode(const LocalLink::Record &record, OSC::Message &msg);
+
+}
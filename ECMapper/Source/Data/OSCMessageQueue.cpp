@@ -4,7 +4,7 @@ using namespace OSC;
 
 void OSCMessageFifo::add(const Message *message) {
     if (getMessageCount() >= queueSize-1) {
-        std::cout << "OSCMessage buffer overflow!" << std::endl;
+        overflowCount.fetch_add(1, std::memory_order_relaxed);
         fifo.reset();
     }
         
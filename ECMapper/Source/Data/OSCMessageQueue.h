@@ -29,8 +29,15 @@ struct Message {
     unsigned int pedal = 0;
     unsigned int value = 0;
     DeviceType device = DeviceType::None;
+    juce::uint32 callbackTime = 0; // LatencyTrace timestamps, key messages only
+    juce::uint32 sendTime = 0;
+    juce::uint32 receiveTime = 0;
+    int instance = 0; // which instrument of its type, from 0 to MaxInstances-1. LEDs: AllInstances for every one.
 };
 
+const int MaxInstances = 4; // instruments of one type played at the same time
+const int AllInstances = -1;
+
 const int MessageSize = sizeof(Message)/sizeof(int);
 const int queueSize = 1024;
 
@@ -39,7 +46,9 @@ public:
     void add(const Message *message);
     void read(Message *message);
     int getMessageCount() const;
+    juce::int64 getOverflowCount() const { return overflowCount.load(std::memory_order_relaxed); }
 private:
+    std::atomic<juce::int64> overflowCount { 0 };
     juce::AbstractFifo fifo { queueSize * MessageSize };
     int buffer[queueSize * MessageSize];
 };
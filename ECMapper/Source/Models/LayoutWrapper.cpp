@@ -1,13 +1,11 @@
 #include "LayoutWrapper.h"
 
 juce::ValueTree LayoutWrapper::getLayoutTree(DeviceType deviceType, juce::ValueTree &rootState) {
-    auto deviceChild = rootState.getOrCreateChildWithName(id_device + juce::String((int)deviceType), nullptr);
-    return deviceChild.getOrCreateChildWithName(id_layout, nullptr);
+    return ModelCache::getLayoutTree(deviceType, rootState);
 }
 
 juce::ValueTree LayoutWrapper::getKeyTree(KeyId keyId, juce::ValueTree &rootState) {
-    auto layoutTree = getLayoutTree(keyId.deviceType, rootState);
-    return layoutTree.getOrCreateChildWithName(id_key + "_" + juce::String(keyId.course) + "_" + juce::String(keyId.keyNo), nullptr);
+    return ModelCache::getKeyTree(keyId.deviceType, keyId.course, keyId.keyNo, rootState);
 }
 
 void LayoutWrapper::addListener(DeviceType deviceType, juce::ValueTree::Listener *listener, juce::ValueTree &rootState) {
@@ -16,7 +14,10 @@ void LayoutWrapper::addListener(DeviceType deviceType, juce::ValueTree::Listener
 }
 
 LayoutWrapper::LayoutKey LayoutWrapper::getLayoutKey(KeyId keyId, juce::ValueTree &rootState) {
-    auto keyTree = getKeyTree(keyId, rootState);
+    return readLayoutKey(keyId, getKeyTree(keyId, rootState));
+}
+
+LayoutWrapper::LayoutKey LayoutWrapper::readLayoutKey(KeyId keyId, const juce::ValueTree &keyTree) {
     auto defaultKeyType = getCorrectDefaultKeyType(keyId.deviceType, keyId.course, keyId.keyNo);
     
     return LayoutKey {
@@ -65,46 +66,44 @@ void LayoutWrapper::setKeyMappingValue(KeyId &keyId, juce::String keyMappingValu
 LayoutWrapper::LayoutKey LayoutWrapper::getLayoutKeyFromKeyTree(juce::ValueTree keyTree) {
     if (!keyTree.isValid())
         return default_key;
-    DeviceType deviceType = getDeviceTypeFromKeyTree(keyTree);
-    int course = keyTree.getType().toString().substring(4, 5).getIntValue();
-    int keyNo = keyTree.getType().toString().substring(6).getIntValue();
+    int course = 0;
+    int keyNo = 0;
+    if (!ModelCache::getKeyPosition(keyTree.getType(), course, keyNo))
+        return default_key;
     KeyId keyId = {
-        .deviceType = deviceType,
+        .deviceType = getDeviceTypeFromKeyTree(keyTree),
         .course = course,
         .keyNo = keyNo
     };
     
-    auto rootState = keyTree.getRoot();
-    return getLayoutKey(keyId, rootState);
+    return readLayoutKey(keyId, keyTree);
 }
 
 DeviceType LayoutWrapper::getDeviceTypeFromKeyTree(juce::ValueTree keyTree) {
     if (!keyTree.isValid())
         return DeviceType::None;
 
-    return (DeviceType)keyTree.getParent().getParent().getType().toString().substring(6, 7).getIntValue();
+    return ModelCache::getDeviceType(keyTree.getParent().getParent().getType());
 }
 
 DeviceType LayoutWrapper::getDeviceTypeFromLayoutTree(juce::ValueTree layoutTree) {
     if (!layoutTree.isValid())
         return DeviceType::None;
 
-    return (DeviceType)layoutTree.getParent().getType().toString().substring(6, 7).getIntValue();
+    return ModelCache::getDeviceType(layoutTree.getParent().getType());
+}
+
+bool LayoutWrapper::isKeyTree(const juce::ValueTree &tree) {
+    int course, keyNo;
+    return ModelCache::getKeyPosition(tree.getType(), course, keyNo);
 }
 
 EigenharpKeyType LayoutWrapper::getCorrectDefaultKeyType(DeviceType deviceType, int course, int keyNo) {
-    switch (deviceType) {
-        case DeviceType::Alpha:
-            return course == 0 ? EigenharpKeyType::Normal : EigenharpKeyType::Perc;
-            break;
-        case DeviceType::Tau:
-            if (course == 0 && keyNo < 72) return EigenharpKeyType::Normal;
-            else if (course == 0 && keyNo >= 72) return EigenharpKeyType::Perc;
-            else return EigenharpKeyType::Button;
-            break;
-        case DeviceType::Pico:
-            return course == 0 ? EigenharpKeyType::Normal : EigenharpKeyType::Button;
-            break;
+    switch (DeviceGeometry::kindOf((int)deviceType, course, keyNo)) {
+        case DeviceGeometry::PercKey:
+            return EigenharpKeyType::Perc;
+        case DeviceGeometry::ButtonKey:
+            return EigenharpKeyType::Button;
         default:
             return EigenharpKeyType::Normal;
     }
@@ -2,6 +2,8 @@
 
 #include <JuceHeader.h>
 #include "Enums.h"
+#include "DeviceGeometry.h"
+#include "ModelCache.h"
 
 class LayoutWrapper {
 public:
@@ -45,11 +47,14 @@ public:
     static LayoutKey getLayoutKeyFromKeyTree(juce::ValueTree keyTree);
     static DeviceType getDeviceTypeFromKeyTree(juce::ValueTree keyTree);
     static DeviceType getDeviceTypeFromLayoutTree(juce::ValueTree layoutTree);
+    static bool isKeyTree(const juce::ValueTree &tree);
+    // from DeviceGeometry::kindOf(), also used by the layout UI
+    static EigenharpKeyType getCorrectDefaultKeyType(DeviceType deviceType, int course, int keyNo);
 
     static void addListener(DeviceType deviceType, juce::ValueTree::Listener *listener, juce::ValueTree &rootState);
 private:
     static juce::ValueTree getKeyTree(KeyId keyId, juce::ValueTree &rootState);
-    static EigenharpKeyType getCorrectDefaultKeyType(DeviceType deviceType, int course, int keyNo);
+    static LayoutKey readLayoutKey(KeyId keyId, const juce::ValueTree &keyTree);
     static KeyMappingType getDefaultMappingTypeFromKeyType(EigenharpKeyType keyType);
 
     static inline const LayoutKey default_key = {
@@ -0,0 +1,156 @@
+#include "ModelCache.h"
+#include "LayoutWrapper.h"
+#include "ZoneWrapper.h"
+#include "SettingsWrapper.h"
+#include <unordered_map>
+
+struct ModelCache::Names {
+    juce::Identifier devices[4];
+    juce::Identifier zones[5];
+    juce::Identifier keys[MaxCourses][MaxKeysPerCourse];
+    // by the address of the pooled name, equal Identifiers share it
+    std::unordered_map<const void*, int> keyPositions;
+
+    Names() {
+        for (int i = 1; i < 4; i++)
+            devices[i] = LayoutWrapper::id_device + juce::String(i);
+        for (int i = 1; i < 5; i++)
+            zones[i] = ZoneWrapper::id_zone + juce::String(i);
+        for (int course = 0; course < MaxCourses; course++) {
+            for (int keyNo = 0; keyNo < MaxKeysPerCourse; keyNo++) {
+                keys[course][keyNo] = LayoutWrapper::id_key + "_" + juce::String(course) + "_" + juce::String(keyNo);
+                keyPositions[keys[course][keyNo].getCharPointer().getAddress()] = course*MaxKeysPerCourse + keyNo;
+            }
+        }
+    }
+};
+
+struct ModelCache::Handles {
+    juce::ValueTree root;
+    juce::ValueTree settings;
+    juce::ValueTree devices[4];
+    juce::ValueTree layouts[4];
+    juce::ValueTree zones[4][5];
+    juce::ValueTree keys[4][MaxCourses][MaxKeysPerCourse];
+};
+
+// guards the entry list and every handle in it, never held while the tree is changed
+static juce::SpinLock handleLock;
+std::vector<std::unique_ptr<ModelCache::Handles>> ModelCache::handleEntries;
+
+const ModelCache::Names& ModelCache::getNames() {
+    static const Names names;
+    return names;
+}
+
+ModelCache::Handles& ModelCache::getHandles(juce::ValueTree &rootState) {
+    const juce::SpinLock::ScopedLockType lock(handleLock);
+    for (auto &entry : handleEntries) {
+        if (entry->root == rootState)
+            return *entry;
+    }
+
+    // a root only referenced from here was replaced, see replaceState()
+    handleEntries.erase(std::remove_if(handleEntries.begin(), handleEntries.end(), [](const std::unique_ptr<Handles> &entry) {
+        return entry->root.getReferenceCount() <= 1;
+    }), handleEntries.end());
+    handleEntries.push_back(std::make_unique<Handles>());
+    handleEntries.back()->root = rootState;
+    return *handleEntries.back();
+}
+
+// resolves outside the lock, getOrCreateChildWithName() may call listeners that read the model again
+template <typename Resolve>
+static juce::ValueTree getCached(juce::ValueTree &handle, Resolve resolve) {
+    {
+        const juce::SpinLock::ScopedLockType lock(handleLock);
+        if (handle.isValid())
+            return handle;
+    }
+    auto tree = resolve();
+    const juce::SpinLock::ScopedLockType lock(handleLock);
+    handle = tree;
+    return tree;
+}
+
+const juce::Identifier& ModelCache::getDeviceId(DeviceType deviceType) {
+    return getNames().devices[isKnownDevice(deviceType) ? (int)deviceType : 0];
+}
+
+const juce::Identifier& ModelCache::getZoneId(Zone zone) {
+    return getNames().zones[isKnownZone(zone) ? (int)zone : 0];
+}
+
+juce::Identifier ModelCache::getKeyId(int course, int keyNo) {
+    if (isKnownKey(course, keyNo))
+        return getNames().keys[course][keyNo];
+    return LayoutWrapper::id_key + "_" + juce::String(course) + "_" + juce::String(keyNo);
+}
+
+DeviceType ModelCache::getDeviceType(const juce::Identifier &type) {
+    auto &names = getNames();
+    for (int i = 1; i < 4; i++) {
+        if (names.devices[i] == type)
+            return (DeviceType)i;
+    }
+    return DeviceType::None;
+}
+
+Zone ModelCache::getZone(const juce::Identifier &type) {
+    auto &names = getNames();
+    for (int i = 1; i < 5; i++) {
+        if (names.zones[i] == type)
+            return (Zone)i;
+    }
+    return Zone::NoZone;
+}
+
+bool ModelCache::getKeyPosition(const juce::Identifier &type, int &course, int &keyNo) {
+    if (!type.isValid())
+        return false;
+    auto &keyPositions = getNames().keyPositions;
+    auto position = keyPositions.find(type.getCharPointer().getAddress());
+    if (position == keyPositions.end())
+        return false;
+    course = position->second/MaxKeysPerCourse;
+    keyNo = position->second%MaxKeysPerCourse;
+    return true;
+}
+
+juce::ValueTree ModelCache::getDeviceTree(DeviceType deviceType, juce::ValueTree &rootState) {
+    if (!isKnownDevice(deviceType))
+        return rootState.getOrCreateChildWithName(LayoutWrapper::id_device + juce::String((int)deviceType), nullptr);
+    return getCached(getHandles(rootState).devices[(int)deviceType], [&] {
+        return rootState.getOrCreateChildWithName(getDeviceId(deviceType), nullptr);
+    });
+}
+
+juce::ValueTree ModelCache::getLayoutTree(DeviceType deviceType, juce::ValueTree &rootState) {
+    if (!isKnownDevice(deviceType))
+        return getDeviceTree(deviceType, rootState).getOrCreateChildWithName(LayoutWrapper::id_layout, nullptr);
+    return getCached(getHandles(rootState).layouts[(int)deviceType], [&] {
+        return getDeviceTree(deviceType, rootState).getOrCreateChildWithName(LayoutWrapper::id_layout, nullptr);
+    });
+}
+
+juce::ValueTree ModelCache::getZoneTree(DeviceType deviceType, Zone zone, juce::ValueTree &rootState) {
+    if (!isKnownDevice(deviceType) || !isKnownZone(zone))
+        return getDeviceTree(deviceType, rootState).getOrCreateChildWithName(ZoneWrapper::id_zone + juce::String((int)zone), nullptr);
+    return getCached(getHandles(rootState).zones[(int)deviceType][(int)zone], [&] {
+        return getDeviceTree(deviceType, rootState).getOrCreateChildWithName(getZoneId(zone), nullptr);
+    });
+}
+
+juce::ValueTree ModelCache::getKeyTree(DeviceType deviceType, int course, int keyNo, juce::ValueTree &rootState) {
+    if (!isKnownDevice(deviceType) || !isKnownKey(course, keyNo))
+        return getLayoutTree(deviceType, rootState).getOrCreateChildWithName(getKeyId(course, keyNo), nullptr);
+    return getCached(getHandles(rootState).keys[(int)deviceType][course][keyNo], [&] {
+        return getLayoutTree(deviceType, rootState).getOrCreateChildWithName(getNames().keys[course][keyNo], nullptr);
+    });
+}
+
+juce::ValueTree ModelCache::getSettingsTree(juce::ValueTree &rootState) {
+    return getCached(getHandles(rootState).settings, [&] {
+        return rootState.getOrCreateChildWithName(SettingsWrapper::id_globalSettings, nullptr);
+    });
+}
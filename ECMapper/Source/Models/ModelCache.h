@@ -0,0 +1,39 @@
+#pragma once
+#include <JuceHeader.h>
+#include "Enums.h"
+
+// Interned names and resolved ValueTree handles behind the wrappers, so a property read is a handle lookup
+// instead of building "device1"/"zone2"/"key_0_17" and searching the children for it.
+// The plugin state only ever gains children, except that replaceState() swaps in a new root, so handles are
+// cached per root and the entries of roots nobody else holds any more are dropped.
+class ModelCache {
+public:
+    static const int MaxCourses = 2;
+    static const int MaxKeysPerCourse = 120;
+
+    static const juce::Identifier& getDeviceId(DeviceType deviceType);
+    static const juce::Identifier& getZoneId(Zone zone);
+    static juce::Identifier getKeyId(int course, int keyNo);
+
+    // reverse lookups on a tree's type, instead of parsing the name
+    static DeviceType getDeviceType(const juce::Identifier &type);
+    static Zone getZone(const juce::Identifier &type);
+    static bool getKeyPosition(const juce::Identifier &type, int &course, int &keyNo);
+
+    // created on first use, like getOrCreateChildWithName()
+    static juce::ValueTree getDeviceTree(DeviceType deviceType, juce::ValueTree &rootState);
+    static juce::ValueTree getLayoutTree(DeviceType deviceType, juce::ValueTree &rootState);
+    static juce::ValueTree getZoneTree(DeviceType deviceType, Zone zone, juce::ValueTree &rootState);
+    static juce::ValueTree getKeyTree(DeviceType deviceType, int course, int keyNo, juce::ValueTree &rootState);
+    static juce::ValueTree getSettingsTree(juce::ValueTree &rootState);
+
+private:
+    struct Names;
+    struct Handles;
+    static std::vector<std::unique_ptr<Handles>> handleEntries;
+    static const Names& getNames();
+    static Handles& getHandles(juce::ValueTree &rootState);
+    static bool isKnownKey(int course, int keyNo) { return course >= 0 && course < MaxCourses && keyNo >= 0 && keyNo < MaxKeysPerCourse; }
+    static bool isKnownDevice(DeviceType deviceType) { return (int)deviceType >= 1 && (int)deviceType <= 3; }
+    static bool isKnownZone(Zone zone) { return (int)zone >= 1 && (int)zone <= 4; }
+};
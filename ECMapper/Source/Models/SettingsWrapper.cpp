@@ -16,7 +16,7 @@ void SettingsWrapper::setIP(juce::String ip, juce::ValueTree &rootState) {
 }
 
 juce::ValueTree SettingsWrapper::getSettingsTree(juce::ValueTree &rootState) {
-    return rootState.getOrCreateChildWithName(id_globalSettings, nullptr);
+    return ModelCache::getSettingsTree(rootState);
 }
 
 void SettingsWrapper::setLowerMPEVoiceCount(int channel, juce::ValueTree &rootState) {
@@ -69,13 +69,23 @@ int SettingsWrapper::getCurrentTabIndex(juce::ValueTree &rootState) {
     return vTree.getProperty(id_activeTab, default_activeTab);
 }
 
+void SettingsWrapper::setMPEStealPolicy(int policy, juce::ValueTree &rootState) {
+    auto vTree = getSettingsTree(rootState);
+    vTree.setProperty(id_mpeStealPolicy, policy, nullptr);
+}
+
+int SettingsWrapper::getMPEStealPolicy(juce::ValueTree &rootState) {
+    auto vTree = getSettingsTree(rootState);
+    return vTree.getProperty(id_mpeStealPolicy, default_mpeStealPolicy);
+}
+
 bool SettingsWrapper::getControlLights(DeviceType deviceType, juce::ValueTree &rootState) {
 //    auto vTree = getSettingsTree(rootState);
-    auto deviceChild = rootState.getOrCreateChildWithName(LayoutWrapper::id_device + juce::String((int)deviceType), nullptr);
+    auto deviceChild = ModelCache::getDeviceTree(deviceType, rootState);
     return deviceChild.getProperty(id_controlLights, true);
 }
 
 void SettingsWrapper::setControlLights(bool value, DeviceType deviceType, juce::ValueTree &rootState) {
-    auto deviceChild = rootState.getOrCreateChildWithName(LayoutWrapper::id_device + juce::String((int)deviceType), nullptr);
+    auto deviceChild = ModelCache::getDeviceTree(deviceType, rootState);
     deviceChild.setProperty(id_controlLights, value, nullptr);
 }
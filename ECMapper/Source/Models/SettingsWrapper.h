@@ -13,6 +13,7 @@ public:
     static inline const juce::Identifier id_upperMPEPB {"uppermpepb"};
     static inline const juce::Identifier id_activeTab {"activetab"};
     static inline const juce::Identifier id_controlLights { "controlLights" };
+    static inline const juce::Identifier id_mpeStealPolicy {"mpestealpolicy"};
 
     static void addListener(juce::ValueTree::Listener *listener, juce::ValueTree &rootState);
 
@@ -28,6 +29,8 @@ public:
     static int getUpperMPEPB(juce::ValueTree &rootState);
     static void setCurrentTabIndex(int index, juce::ValueTree &rootState);
     static int getCurrentTabIndex(juce::ValueTree &rootState);
+    static void setMPEStealPolicy(int policy, juce::ValueTree &rootState);
+    static int getMPEStealPolicy(juce::ValueTree &rootState);
     
     static bool getControlLights(DeviceType deviceType, juce::ValueTree &rootState);
     static void setControlLights(bool value, DeviceType deviceType, juce::ValueTree &rootState);
@@ -39,6 +42,7 @@ private:
     static inline const int default_lowerMPEPB = 48;
     static inline const int default_upperMPEPB = 48;
     static inline const int default_activeTab = 0;
+    static inline const int default_mpeStealPolicy = 1;
 
     static juce::ValueTree getSettingsTree(juce::ValueTree &rootState);
     
@@ -10,8 +10,7 @@ void ZoneWrapper::addListener(DeviceType deviceType, juce::ValueTree::Listener *
 }
 
 juce::ValueTree ZoneWrapper::getZoneTree(DeviceType deviceType, Zone zone, juce::ValueTree &rootState) {
-    auto deviceChild = rootState.getOrCreateChildWithName(id_device + juce::String((int)deviceType), nullptr);
-    return deviceChild.getOrCreateChildWithName(id_zone + juce::String((int)zone), nullptr);
+    return ModelCache::getZoneTree(deviceType, zone, rootState);
 }
 
 MidiChannelType ZoneWrapper::getMidiChannelType(DeviceType deviceType, Zone zone, juce::ValueTree &rootState) {
@@ -81,7 +80,8 @@ ZoneWrapper::MidiValue ZoneWrapper::getMidiValue(DeviceType deviceType, Zone zon
     return midiValChild.isValid() ?
     ZoneWrapper::MidiValue {
             .valueType = (MidiValueType)int(midiValChild.getProperty(id_midiValType)),
-            .ccNo = midiValChild.getProperty(id_midiCCNo)
+            .ccNo = midiValChild.getProperty(id_midiCCNo),
+            .highRes = midiValChild.getProperty(id_midiHighRes, false)
         } : defaultValue;
 }
 
@@ -91,12 +91,17 @@ void ZoneWrapper::setMidiValue(DeviceType deviceType, Zone zone, juce::Identifie
     auto midiValChild = zoneTree.getOrCreateChildWithName(childId, nullptr);
     midiValChild.setProperty(id_midiValType, (int)midiValue.valueType, nullptr);
     midiValChild.setProperty(id_midiCCNo, midiValue.ccNo, nullptr);
+    midiValChild.setProperty(id_midiHighRes, midiValue.highRes, nullptr);
 }
 
 DeviceType ZoneWrapper::getDeviceTypeFromTree(juce::ValueTree tree) {
     auto parentTree = tree.getParent();
-    while (!parentTree.getType().toString().startsWith(id_device))
+    while (parentTree.isValid() && ModelCache::getDeviceType(parentTree.getType()) == DeviceType::None)
         parentTree = parentTree.getParent();
     
-    return (DeviceType)parentTree.getType().toString().substring(6).getIntValue();
+    return ModelCache::getDeviceType(parentTree.getType());
+}
+
+bool ZoneWrapper::isZoneTree(const juce::ValueTree &tree) {
+    return ModelCache::getZone(tree.getType()) != Zone::NoZone;
 }
@@ -1,12 +1,14 @@
 #pragma once
 #include <JuceHeader.h>
 #include "Enums.h"
+#include "ModelCache.h"
 
 class ZoneWrapper {
 public:
     struct MidiValue {
         MidiValueType valueType = MidiValueType::CC;
         int ccNo = 0;
+        bool highRes = false; // 14-bit MSB/LSB pair on ccNo and ccNo+32, only for CC 0-31
     };
 
     static inline const juce::Identifier id_zone { "zone" };
@@ -26,6 +28,7 @@ public:
     static inline const juce::Identifier id_breath { "breath" };
     static inline const juce::Identifier id_midiValType { "midiValType" };
     static inline const juce::Identifier id_midiCCNo { "midiCCNo" };
+    static inline const juce::Identifier id_midiHighRes { "midiHighRes" };
     static inline const juce::Identifier id_midiVal { "midiVal" };
 
     static MidiChannelType getMidiChannelType(DeviceType deviceType, Zone zone, juce::ValueTree &rootState);
@@ -41,6 +44,7 @@ public:
     static bool getEnabled(DeviceType deviceType, Zone zone, juce::ValueTree &rootState);
     static void setMidiValue(DeviceType deviceType, Zone zone, juce::Identifier childId, MidiValue midiValue, juce::ValueTree &rootState);
     static DeviceType getDeviceTypeFromTree(juce::ValueTree tree);
+    static bool isZoneTree(const juce::ValueTree &tree);
 
     static void addListener(DeviceType deviceType, juce::ValueTree::Listener *listener, juce::ValueTree &rootState);
 
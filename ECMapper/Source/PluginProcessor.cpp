@@ -7,13 +7,37 @@ ECMapperAudioProcessor::ECMapperAudioProcessor() :
                .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
     logger(false, true),
     pluginState(*this, nullptr, id_state, createParameterLayout()),
-    osc(&oscSendQueue, &oscReceiveQueue, &logger),
-    configLookups { ConfigLookup(DeviceType::Alpha, pluginState), ConfigLookup(DeviceType::Tau, pluginState), ConfigLookup(DeviceType::Pico, pluginState)}, midiGenerator(configLookups), layoutChangeHandler(&oscSendQueue, this, configLookups) {
+    osc(&oscSendQueue, &oscReceiveQueue, &logger, &latencyTrace, metrics),
+    configLookups { ConfigLookup(DeviceType::Alpha, pluginState), ConfigLookup(DeviceType::Tau, pluginState), ConfigLookup(DeviceType::Pico, pluginState)}, midiGenerator(configLookups), layoutChangeHandler(&oscSendQueue, this, configLookups, &midiGenerator),
+    processBlockTime(metrics.addHistogram("process_block")), midiBytes(metrics.addCounter("midi_bytes")) {
     pluginState.state.addListener(&layoutChangeHandler);
     pluginState.state.addListener(this);
+    
+    metrics.addGauge("receive_queue", [this] { return (juce::int64)oscReceiveQueue.getMessageCount(); });
+    metrics.addCounter("receive_overflows", [this] { return oscReceiveQueue.getOverflowCount(); });
+    metrics.addGauge("send_queue", [this] { return (juce::int64)oscSendQueue.getMessageCount(); });
+    metrics.addCounter("send_overflows", [this] { return oscSendQueue.getOverflowCount(); });
+    metrics.addCounter("stuck_keys", [this] { return midiGenerator.getStuckKeyCount(); });
+    // devices with at least one enabled zone, EigenCore does not send this instance anything for the others
+    osc.getSubscribedDevices = [this] {
+        int devices = 0;
+        for (auto deviceType : { DeviceType::Alpha, DeviceType::Tau, DeviceType::Pico }) {
+            for (auto zone : { Zone::Zone1, Zone::Zone2, Zone::Zone3 }) {
+                if (ZoneWrapper::getEnabled(deviceType, zone, pluginState.state))
+                    devices |= 1 << (int)deviceType;
+            }
+        }
+        return devices;
+    };
+    osc.getSubscription = [this](DeviceType deviceType) {
+        return configLookups[(int)deviceType - 1].getSubscription();
+    };
+    // ECMAPPER_METRICS=file:<path> or udp:<host>:<port> exports every sample, see Metrics.h
+    metricsSampler = std::make_unique<Metrics::Sampler>(metrics, juce::SystemStats::getEnvironmentVariable("ECMAPPER_METRICS", ""));
 }
 
 ECMapperAudioProcessor::~ECMapperAudioProcessor() {
+    metricsSampler = nullptr;
 }
 
 const juce::String ECMapperAudioProcessor::getName() const {
@@ -90,37 +114,65 @@ void ECMapperAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce
     if (isBypassed)
         logger.log("Going out of bypass mode.");
     isBypassed = false;
+    auto blockStart = LatencyTrace::nowMicros();
+    SpanTrace::setThreadName("processBlock");
+    TRACE_SPAN("processBlock");
     
     if (juce::JUCEApplicationBase::isStandaloneApp())
         buffer.clear();
 
     midiMessages.clear();
     checkConnectionChanges();
+    osc.pollLocalLink();
     
-    static OSC::Message msg;
-    static OSC::Message outgoingMsg;
-    if (!layoutChangeHandler.layoutMidiRPNSent) {
-        midiGenerator.createLayoutRPNs(midiMessages);
-        layoutChangeHandler.layoutMidiRPNSent = true;
-    }
+    // locals, several plugin instances run processBlock at the same time
+    OSC::Message msg;
+    midiGenerator.addLayoutRPNs(midiMessages);
+    // UDP first, when EigenCore switches to the local link the older messages are in the receive queue
     while (osc.receiveQueue->getMessageCount() > 0) {
         osc.receiveQueue->read(&msg);
-        if (msg.type == OSC::MessageType::Device) {
-            layoutChangeHandler.sendLEDMsgForAllKeys(msg.device);
-            logger.log("Refresh lights because of Device message.");
-        }
-        else {
-            outgoingMsg.type = OSC::MessageType::Undefined;
-            if (midiGenerator.initialized)
-                midiGenerator.processOSCMessage(msg, outgoingMsg, midiMessages);
-            if (outgoingMsg.type == OSC::MessageType::LED) {
-                outgoingMsg.device = msg.device;
-                outgoingMsg.course = msg.course;
-                outgoingMsg.key = msg.key;
-                oscSendQueue.add(&outgoingMsg);
-            }
+        processIncomingMessage(msg, midiMessages);
+    }
+    while (osc.localReceiveQueue.getMessageCount() > 0) {
+        osc.localReceiveQueue.read(&msg);
+        processIncomingMessage(msg, midiMessages);
+    }
+    if (midiGenerator.initialized)
+        midiGenerator.releaseStuckKeys(midiMessages);
+    midiBytes.add(midiMessages.data.size());
+    processBlockTime.add(LatencyTrace::nowMicros() - blockStart);
+}
+
+void ECMapperAudioProcessor::processIncomingMessage(OSC::Message &msg, juce::MidiBuffer &midiMessages) {
+    OSC::Message outgoingMsg;
+    if (msg.type == OSC::MessageType::Device) {
+        layoutChangeHandler.sendLEDMsgForAllKeys(msg.device);
+        logger.log("Refresh lights because of Device message.");
+        return;
+    }
+    
+    outgoingMsg.type = OSC::MessageType::Undefined;
+    auto dequeueTime = msg.receiveTime == 0 ? 0 : LatencyTrace::nowMicros();
+    auto midiBufferSize = midiMessages.data.size();
+    if (midiGenerator.initialized) {
+        TRACE_SPAN("MidiGenerator");
+        midiGenerator.processOSCMessage(msg, outgoingMsg, midiMessages);
+    }
+    if (dequeueTime != 0) {
+        latencyTrace.record(LatencyTrace::ReceiveToDequeue, msg.receiveTime, dequeueTime);
+        if (midiMessages.data.size() > midiBufferSize) {
+            auto midiTime = LatencyTrace::nowMicros();
+            latencyTrace.record(LatencyTrace::DequeueToMidi, dequeueTime, midiTime);
+            latencyTrace.record(LatencyTrace::CallbackToMidi, msg.callbackTime, midiTime);
         }
     }
+    if (outgoingMsg.type == OSC::MessageType::LED) {
+        outgoingMsg.device = msg.device;
+        outgoingMsg.instance = msg.instance;
+        outgoingMsg.course = msg.course;
+        outgoingMsg.key = msg.key;
+        oscSendQueue.add(&outgoingMsg);
+    }
 }
 
 void ECMapperAudioProcessor::processBlockBypassed(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages) {
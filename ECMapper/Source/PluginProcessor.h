@@ -48,10 +48,14 @@ public:
 
     juce::Identifier id_state = "pluginState";
     juce::AudioProcessorValueTreeState pluginState;
+    LatencyTrace latencyTrace;
+    Metrics::Registry metrics { "ecmapper" };
+    std::unique_ptr<Metrics::Sampler> metricsSampler;
 private:
     void updateIPandPorts();
     void checkConnectionChanges();
     void refreshLights();
+    void processIncomingMessage(OSC::Message &msg, juce::MidiBuffer &midiMessages);
     
     OSCCommunication osc;
     OSC::OSCMessageFifo oscSendQueue;
@@ -63,6 +67,8 @@ private:
     LayoutChangeHandler layoutChangeHandler;
     bool prevEigenCoreConnectedState = false;
     bool isBypassed = false;
+    LatencyHistogram &processBlockTime;
+    Metrics::Counter &midiBytes;
     
     
     void valueTreePropertyChanged(juce::ValueTree &vTree, const juce::Identifier &property) override;
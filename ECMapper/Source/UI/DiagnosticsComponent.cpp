@@ -0,0 +1,85 @@
+#include "DiagnosticsComponent.h"
+
+DiagnosticsComponent::DiagnosticsComponent(LatencyTrace &latencyTrace, Metrics::Sampler &metricsSampler) : latencyTrace(latencyTrace), metricsSampler(metricsSampler) {
+    latencyLabel.setText("Key latency (EigenCore callback to MIDI buffer):", juce::dontSendNotification);
+    addAndMakeVisible(latencyLabel);
+    
+    latencyText.setMultiLine(true);
+    latencyText.setReadOnly(true);
+    latencyText.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain));
+    addAndMakeVisible(latencyText);
+    
+    dumpButton.setButtonText("Dump");
+    dumpButton.onClick = [&] {
+        latencyTrace.dumpToFile(getDumpFile("latency"));
+    };
+    addAndMakeVisible(dumpButton);
+    
+    resetButton.setButtonText("Reset");
+    resetButton.onClick = [&] {
+        latencyTrace.reset();
+    };
+    addAndMakeVisible(resetButton);
+    
+    traceButton.setButtonText("Trace spans");
+    traceButton.setToggleState(SpanTrace::isEnabled(), juce::dontSendNotification);
+    traceButton.onClick = [&] {
+        SpanTrace::setEnabled(traceButton.getToggleState());
+    };
+    addAndMakeVisible(traceButton);
+    
+    dumpTraceButton.setButtonText("Dump trace");
+    dumpTraceButton.onClick = [&] {
+        SpanTrace::dumpToFile(getDumpFile("trace").withFileExtension("json"), "ECMapper");
+    };
+    addAndMakeVisible(dumpTraceButton);
+    
+    metricsLabel.setText("Runtime metrics:", juce::dontSendNotification);
+    addAndMakeVisible(metricsLabel);
+    
+    metricsText.setMultiLine(true);
+    metricsText.setReadOnly(true);
+    metricsText.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain));
+    addAndMakeVisible(metricsText);
+    
+    startTimer(500);
+}
+
+DiagnosticsComponent::~DiagnosticsComponent() {
+    stopTimer();
+}
+
+void DiagnosticsComponent::paint(juce::Graphics &g) {
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+}
+
+void DiagnosticsComponent::resized() {
+    auto area = getLocalBounds();
+    area.reduce(10, 10);
+    auto buttonArea = area.removeFromBottom(30);
+    dumpButton.setBounds(buttonArea.removeFromLeft(100));
+    buttonArea.removeFromLeft(10);
+    resetButton.setBounds(buttonArea.removeFromLeft(100));
+    buttonArea.removeFromLeft(10);
+    traceButton.setBounds(buttonArea.removeFromLeft(100));
+    dumpTraceButton.setBounds(buttonArea.removeFromLeft(100));
+    area.removeFromBottom(10);
+    latencyLabel.setBounds(area.removeFromTop(25));
+    latencyText.setBounds(area.removeFromTop(120));
+    area.removeFromTop(10);
+    metricsLabel.setBounds(area.removeFromTop(25));
+    metricsText.setBounds(area);
+}
+
+void DiagnosticsComponent::timerCallback() {
+    if (!isShowing())
+        return;
+    
+    auto summary = latencyTrace.getSummary();
+    latencyText.setText(summary.isEmpty() ? "No traced key events yet." : summary, false);
+    metricsText.setText(metricsSampler.getSummary(), false);
+}
+
+juce::File DiagnosticsComponent::getDumpFile(const juce::String &name) {
+    return juce::File("~/Documents/ECMapperLogs/").getChildFile(name + "_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".txt");
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <JuceHeader.h>
+#include "LatencyTrace.h"
+#include "Metrics.h"
+#include "SpanTrace.h"
+
+class DiagnosticsComponent : public juce::Component, private juce::Timer {
+public:
+    DiagnosticsComponent(LatencyTrace &latencyTrace, Metrics::Sampler &metricsSampler);
+    ~DiagnosticsComponent() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    juce::File getDumpFile(const juce::String &name);
+
+    LatencyTrace &latencyTrace;
+    juce::Label latencyLabel;
+    juce::TextEditor latencyText;
+    juce::TextButton dumpButton;
+    juce::TextButton resetButton;
+    juce::ToggleButton traceButton;
+    juce::TextButton dumpTraceButton;
+    Metrics::Sampler &metricsSampler;
+    juce::Label metricsLabel;
+    juce::TextEditor metricsText;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiagnosticsComponent)
+};
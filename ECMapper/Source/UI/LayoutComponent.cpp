@@ -1,9 +1,8 @@
 #include "LayoutComponent.h"
 
-LayoutComponent::LayoutComponent(DeviceType deviceType, float widthFactor, float heightFactor, juce::AudioProcessorValueTreeState &pluginState) : PanelComponent(widthFactor, heightFactor), pluginState(pluginState)
+LayoutComponent::LayoutComponent(DeviceType deviceType, float widthFactor, float heightFactor, juce::AudioProcessorValueTreeState &pluginState) : PanelComponent(widthFactor, heightFactor), geometry(DeviceGeometry::get((int)deviceType)), pluginState(pluginState)
 {
     this->deviceType = deviceType;
-    setKeyCounts(deviceType);
     keyImgNormal = createBtnImage(juce::Colour::fromFloatRGBA(1.0f, 1.0f, 1.0f, 0.0f));
     keyImgOver = createBtnImage(juce::Colour::fromFloatRGBA(1.0f, 1.0f, 1.0f, 0.8f));
     keyImgDown = createBtnImage(juce::Colour::fromFloatRGBA(1.0f, 1.0f, 1.0f, 1.0f));
@@ -190,33 +189,10 @@ void LayoutComponent::deselectAllKeys() {
 }
 
 void LayoutComponent::createKeys() {
-    
-    for (int i = 0; i < getNormalkeyCount(); i++) {
-        LayoutWrapper::KeyId id = { .deviceType = deviceType, .course = 0, .keyNo = i };
-        keys.push_back(new KeyConfigComponent(id, EigenharpKeyType::Normal, pluginState));
-    }
-
-    if (deviceType == DeviceType::Pico) {
-        for (int i = 0; i < getButtonCount(); i++) {
-            LayoutWrapper::KeyId id = { .deviceType = deviceType, .course = 1, .keyNo = i };
-            keys.push_back(new KeyConfigComponent(id, EigenharpKeyType::Button, pluginState));
-        }
-    }
-    else if (deviceType == DeviceType::Alpha) {
-        for (int i = 0; i < getPercKeyCount(); i++) {
-            LayoutWrapper::KeyId id = { .deviceType = deviceType, .course = 1, .keyNo = i };
-            keys.push_back(new KeyConfigComponent(id, EigenharpKeyType::Perc, pluginState));
-        }
-    }
-    else { // Note: Tau course 1 (the 8 buttons) is numbered from 5 upwards
-        for (int i = getPercKeyStartIndex(); i < getButtonStartIndex(); i++) {
-            LayoutWrapper::KeyId id = { .deviceType = deviceType, .course = 0, .keyNo = i };
-            keys.push_back(new KeyConfigComponent(id, EigenharpKeyType::Perc, pluginState));
-        }
-        for (int i = 5; i < 13; i++) {
-            LayoutWrapper::KeyId id = { .deviceType = deviceType, .course = 1, .keyNo = i };
-            keys.push_back(new KeyConfigComponent(id, EigenharpKeyType::Button, pluginState));
-        }
+    // flat key order is normal keys, percussion keys, buttons on every instrument, so keys[i] is key index i
+    for (int i = 0; i < getTotalKeyCount(); i++) {
+        LayoutWrapper::KeyId id = { .deviceType = deviceType, .course = DeviceGeometry::courseOf((int)deviceType, i), .keyNo = DeviceGeometry::keyOf((int)deviceType, i) };
+        keys.push_back(new KeyConfigComponent(id, LayoutWrapper::getCorrectDefaultKeyType(deviceType, id.course, id.keyNo), pluginState));
     }
     
     for (int i = 0; i < getTotalKeyCount(); i++) {
@@ -368,80 +344,37 @@ void LayoutComponent::valuesChanged(ChordSectionComponent*) {
 }
 
 int LayoutComponent::getNormalkeyCount() const {
-    return normalKeyCount;
+    return geometry.courses[0].normalKeys + geometry.courses[1].normalKeys;
 }
 
 int LayoutComponent::getPercKeyCount() const {
-    return percKeyCount;
+    return geometry.courses[0].percKeys + geometry.courses[1].percKeys;
 }
 
 int LayoutComponent::getButtonCount() const {
-    return buttonCount;
+    return geometry.courses[0].buttons + geometry.courses[1].buttons;
 }
 
 int LayoutComponent::getStripCount() const {
-    return stripCount;
+    return geometry.strips;
 }
 
 int LayoutComponent::getKeyRowCount() const {
-    return keyRowCount;
+    return geometry.keyRows;
 }
 
 const int* LayoutComponent::getKeyRowLengths() const {
-    return keyRowLengths;
+    return geometry.keyRowLengths;
 }
 
 int LayoutComponent::getTotalKeyCount() const {
-    return normalKeyCount + percKeyCount + buttonCount;
+    return geometry.keyCount();
 }
 
 int LayoutComponent::getPercKeyStartIndex() const {
-    return normalKeyCount;
+    return getNormalkeyCount();
 }
 
 int LayoutComponent::getButtonStartIndex() const {
-    return normalKeyCount + percKeyCount;
-}
-
-void LayoutComponent::setKeyCounts(DeviceType deviceType) {
-    switch(deviceType) {
-        case DeviceType::Alpha:
-            normalKeyCount = 120;
-            percKeyCount = 12;
-            keyRowCount = 5;
-            keyRowLengths[0] = 24;
-            keyRowLengths[1] = 24;
-            keyRowLengths[2] = 24;
-            keyRowLengths[3] = 24;
-            keyRowLengths[4] = 24;
-            buttonCount = 0;
-            stripCount = 2;
-            break;
-        case DeviceType::Tau:
-            normalKeyCount = 72;
-            percKeyCount = 12;
-            keyRowCount = 4;
-            keyRowLengths[0] = 16;
-            keyRowLengths[1] = 16;
-            keyRowLengths[2] = 20;
-            keyRowLengths[3] = 20;
-            keyRowLengths[4] = 0;
-            buttonCount = 8;
-            stripCount = 1;
-            break;
-        case DeviceType::Pico:
-            normalKeyCount = 18;
-            percKeyCount = 0;
-            keyRowCount = 2;
-            keyRowLengths[0] = 9;
-            keyRowLengths[1] = 9;
-            keyRowLengths[2] = 0;
-            keyRowLengths[3] = 0;
-            keyRowLengths[4] = 0;
-            buttonCount = 4;
-            stripCount = 1;
-            break;
-        default:
-            break;
-    }
+    return getNormalkeyCount() + getPercKeyCount();
 }
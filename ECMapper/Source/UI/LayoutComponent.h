@@ -54,15 +54,8 @@ private:
     int navigateNormalKeys(const juce::KeyPress &key, int selectedKeyIndex);
     int navigatePercKeys(const juce::KeyPress &key, int selectedKeyIndex);
     int navigateButtons(const juce::KeyPress &key, int selectedKeyIndex);
-    void setKeyCounts(DeviceType deviceType);
-
     
-    int normalKeyCount;
-    int percKeyCount;
-    int buttonCount;
-    int stripCount;
-    int keyRowCount;
-    int keyRowLengths[5];
+    const DeviceGeometry::Device &geometry;
     DeviceType deviceType;
     juce::AudioProcessorValueTreeState &pluginState;
 
@@ -1,6 +1,6 @@
 #include "MainComponent.h"
 
-MainComponent::MainComponent(juce::AudioProcessorValueTreeState &pluginState): lowerMPEVoiceCount("Lower MPE voices:", 2, 0, 15, true), upperMPEVoiceCount("Upper MPE voices:", 2, 0, 15, true),  lowerMPEPitchbendRange("Lower MPE pb:", 2, 0, 96, true), upperMPEPitchbendRange("Upper MPE pb:", 2, 0, 96, true) {
+MainComponent::MainComponent(juce::AudioProcessorValueTreeState &pluginState, LatencyTrace &latencyTrace, Metrics::Sampler &metricsSampler): lowerMPEVoiceCount("Lower MPE voices:", 2, 0, 15, true), upperMPEVoiceCount("Upper MPE voices:", 2, 0, 15, true),  lowerMPEPitchbendRange("Lower MPE pb:", 2, 0, 96, true), upperMPEPitchbendRange("Upper MPE pb:", 2, 0, 96, true), diagnostics(latencyTrace, metricsSampler) {
     SettingsWrapper::addListener(this, pluginState.state);
     oscIPInput.setText(SettingsWrapper::getIP(pluginState.state));
     oscIPInput.onFocusLost = [&] {
@@ -27,6 +27,15 @@ MainComponent::MainComponent(juce::AudioProcessorValueTreeState &pluginState): l
         SettingsWrapper::setUpperMPEPB(upperMPEPitchbendRange.getValue(), pluginState.state);
     };
     
+    mpeStealPolicy.setLabelText("MPE voice steal:", true);
+    mpeStealPolicy.addItem("Oldest", 1);
+    mpeStealPolicy.addItem("Newest", 2);
+    mpeStealPolicy.addItem("Share", 3);
+    mpeStealPolicy.setSelectedItemId(SettingsWrapper::getMPEStealPolicy(pluginState.state));
+    mpeStealPolicy.box.onChange = [&] {
+        SettingsWrapper::setMPEStealPolicy(mpeStealPolicy.box.getSelectedId(), pluginState.state);
+    };
+    
     tabPages[0] = new TabPage(0, DeviceType::Alpha, pluginState);
     tabPages[1] = new TabPage(1, DeviceType::Tau, pluginState);
     tabPages[2] = new TabPage(2, DeviceType::Pico, pluginState);
@@ -34,6 +43,7 @@ MainComponent::MainComponent(juce::AudioProcessorValueTreeState &pluginState): l
     tabs.addTab("Alpha", bgColour, tabPages[0], false);
     tabs.addTab("Tau", bgColour, tabPages[1], false);
     tabs.addTab("Pico", bgColour, tabPages[2], false);
+    tabs.addTab("Diagnostics", bgColour, &diagnostics, false);
     tabs.setCurrentTabIndex(SettingsWrapper::getCurrentTabIndex(pluginState.state));
     tabs.onTabChanged = [&](int index){
         SettingsWrapper::setCurrentTabIndex(index, pluginState.state);
@@ -47,6 +57,7 @@ MainComponent::MainComponent(juce::AudioProcessorValueTreeState &pluginState): l
     addAndMakeVisible(upperMPEVoiceCount);
     addAndMakeVisible(lowerMPEPitchbendRange);
     addAndMakeVisible(upperMPEPitchbendRange);
+    addAndMakeVisible(mpeStealPolicy);
     
     resized();
 }
@@ -79,6 +90,8 @@ void MainComponent::resized() {
     upperMPEVoiceCount.setBounds(header.removeFromRight(area.getWidth()*0.12));
     header.removeFromRight(area.getWidth()*0.02);
     lowerMPEVoiceCount.setBounds(header.removeFromRight(area.getWidth()*0.12));
+    header.removeFromRight(area.getWidth()*0.02);
+    mpeStealPolicy.setBounds(header.removeFromRight(area.getWidth()*0.12));
     tabs.setBounds(area);
     
 }
@@ -7,10 +7,11 @@
 #include "DropdownComponent.h"
 #include "../Models/SettingsWrapper.h"
 #include "TabButtonBarComponent.h"
+#include "DiagnosticsComponent.h"
 
 class MainComponent : public juce::Component, public juce::ValueTree::Listener {
 public:
-    MainComponent(juce::AudioProcessorValueTreeState &pluginState);
+    MainComponent(juce::AudioProcessorValueTreeState &pluginState, LatencyTrace &latencyTrace, Metrics::Sampler &metricsSampler);
     ~MainComponent() override;
 
     void paint (juce::Graphics&) override;
@@ -22,9 +23,11 @@ private:
     NumberInputComponent upperMPEVoiceCount;
     NumberInputComponent lowerMPEPitchbendRange;
     NumberInputComponent upperMPEPitchbendRange;
+    DropdownComponent mpeStealPolicy;
     juce::Label oscIPLabel;
     juce::TextEditor oscIPInput;
 
+    DiagnosticsComponent diagnostics;
     TabButtonBarComponent tabs;
     TabPage *tabPages[3];
 
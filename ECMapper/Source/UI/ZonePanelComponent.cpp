@@ -114,9 +114,13 @@ void ZonePanelComponent::setStandardMidiDropdownParams(DropdownComponent &dropdo
     dropdown.addItem("Chan aftertouch", 130);
     dropdown.addItem("Poly aftertouch", 131);
     dropdown.addItem("Off", 132);
+    for (int i = 0; i < 32; i++)
+        dropdown.addItem("CC #" + juce::String(i) + " (14-bit)", i+133);
 
     ZoneWrapper::MidiValue midiValue = ZoneWrapper::getMidiValue(deviceType, zone, treeId, defaultValue, pluginState.state);
-    if (midiValue.valueType == MidiValueType::CC)
+    if (midiValue.valueType == MidiValueType::CC && midiValue.highRes && midiValue.ccNo < 32)
+        dropdown.box.setSelectedItemIndex(132 + midiValue.ccNo);
+    else if (midiValue.valueType == MidiValueType::CC)
         dropdown.box.setSelectedItemIndex(midiValue.ccNo);
     else
         dropdown.box.setSelectedItemIndex(126 + (int)midiValue.valueType);
@@ -128,6 +132,11 @@ void ZonePanelComponent::setStandardMidiDropdownParams(DropdownComponent &dropdo
             midiValue.valueType = MidiValueType::CC;
             midiValue.ccNo = selIndex;
         }
+        else if (selIndex >= 132) {
+            midiValue.valueType = MidiValueType::CC;
+            midiValue.ccNo = selIndex - 132;
+            midiValue.highRes = true;
+        }
         else {
             midiValue.valueType = (MidiValueType)(selIndex - 126);
             midiValue.ccNo = 0;
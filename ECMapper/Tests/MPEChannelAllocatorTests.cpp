@@ -0,0 +1,75 @@
+#include <JuceHeader.h>
+#include "../Source/Data/MPEChannelAllocator.h"
+
+// Run with ecmapper_bench --unit-tests
+class MPEChannelAllocatorTests : public juce::UnitTest {
+public:
+    MPEChannelAllocatorTests() : juce::UnitTest("MPEChannelAllocator", "ECMapper") {}
+
+    void runTest() override {
+        for (auto policy : { MPEChannelAllocator::StealPolicy::Oldest, MPEChannelAllocator::StealPolicy::Newest, MPEChannelAllocator::StealPolicy::Share })
+            testStealAndRelease(policy);
+        testNoteOffForStolenKey();
+    }
+
+private:
+    static juce::MPEZoneLayout::Zone createLowerZone(int memberChannels) {
+        juce::MPEZoneLayout layout;
+        layout.setLowerZone(memberChannels);
+        return layout.getLowerZone();
+    }
+
+    void testStealAndRelease(MPEChannelAllocator::StealPolicy policy) {
+        beginTest("steal and release all, policy " + juce::String((int)policy));
+        MPEChannelAllocator allocator;
+        allocator.setZone(createLowerZone(4));
+        allocator.setStealPolicy(policy);
+
+        int stolenKeyIndex;
+        for (int key = 0; key < 4; key++)
+            allocator.noteOn(key, stolenKeyIndex);
+        expectEquals(allocator.getOccupiedChannelCount(), 4);
+
+        for (int key = 4; key < 10; key++) {
+            allocator.noteOn(key, stolenKeyIndex);
+            expectEquals(allocator.getOccupiedChannelCount(), 4);
+            if (policy == MPEChannelAllocator::StealPolicy::Share)
+                expectEquals(stolenKeyIndex, MPEChannelAllocator::NO_KEY);
+            else
+                expect(stolenKeyIndex != MPEChannelAllocator::NO_KEY);
+        }
+        expectEquals(allocator.getStealCount(), policy == MPEChannelAllocator::StealPolicy::Share ? 0 : 6);
+
+        for (int key = 0; key < 10; key++)
+            allocator.noteOff(key);
+        expectEquals(allocator.getOccupiedChannelCount(), 0);
+
+        // every channel is free again, so nothing is stolen
+        for (int key = 0; key < 4; key++) {
+            allocator.noteOn(key, stolenKeyIndex);
+            expectEquals(stolenKeyIndex, MPEChannelAllocator::NO_KEY);
+        }
+        expectEquals(allocator.getOccupiedChannelCount(), 4);
+    }
+
+    void testNoteOffForStolenKey() {
+        beginTest("note off for a stolen key keeps the new owner");
+        MPEChannelAllocator allocator;
+        allocator.setZone(createLowerZone(1));
+
+        int stolenKeyIndex;
+        int channel = allocator.noteOn(0, stolenKeyIndex);
+        expectEquals(allocator.noteOn(1, stolenKeyIndex), channel);
+        expectEquals(stolenKeyIndex, 0);
+        expectEquals(allocator.getChannelForKey(0), 0);
+
+        allocator.noteOff(0);
+        expectEquals(allocator.getOccupiedChannelCount(), 1);
+        expectEquals(allocator.getChannelForKey(1), channel);
+
+        allocator.noteOff(1);
+        expectEquals(allocator.getOccupiedChannelCount(), 0);
+    }
+};
+
+static MPEChannelAllocatorTests mpeChannelAllocatorTests;
@@ -0,0 +1,64 @@
+#include <JuceHeader.h>
+#include <cstring>
+#include "../Source/Data/OSCDecoder.h"
+
+// libFuzzer harness for both OSCDecoder::decode overloads, built with -DECMAPPER_BUILD_FUZZ=ON.
+// The first byte picks the address, the second the argument count, and every argument takes a type byte and four
+// value bytes. Whatever is left over becomes a LocalLink::Record.
+namespace {
+
+const char *addresses[] = {
+    "/EigenCore/key",
+    "/EigenCore/breath",
+    "/EigenCore/strip",
+    "/EigenCore/pedal",
+    "/EigenCore/device",
+    "/EigenCore/ping"
+};
+
+struct FuzzInput {
+    const uint8_t *data;
+    size_t size;
+
+    uint8_t nextByte() {
+        if (size == 0)
+            return 0;
+        size--;
+        return *data++;
+    }
+
+    juce::int32 nextInt32() {
+        juce::uint32 value = 0;
+        for (int i = 0; i < 4; i++)
+            value = (value << 8) | nextByte();
+        return (juce::int32)value;
+    }
+};
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FuzzInput input { data, size };
+    OSC::Message msg;
+
+    juce::OSCMessage message { juce::OSCAddressPattern(addresses[input.nextByte() % juce::numElementsInArray(addresses)]) };
+    int argumentCount = input.nextByte() % 12;
+    for (int i = 0; i < argumentCount; i++) {
+        auto type = input.nextByte() % 4;
+        auto value = input.nextInt32();
+        // half of the arguments are ints, so most messages get past the type check
+        if (type < 2)
+            message.addInt32(value);
+        else if (type == 2)
+            message.addFloat32((float)value);
+        else
+            message.addString(juce::String(value));
+    }
+    OSCDecoder::decode(message, msg);
+
+    LocalLink::Record record {};
+    if (input.size > 0)
+        std::memcpy(&record, input.data, std::min(input.size, sizeof(record)));
+    OSCDecoder::decode(record, msg);
+    return 0;
+}
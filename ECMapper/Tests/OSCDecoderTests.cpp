@@ -0,0 +1,164 @@
+#include <JuceHeader.h>
+#include "../Source/Data/OSCDecoder.h"
+
+// Run with ecmapper_bench --unit-tests
+class OSCDecoderTests : public juce::UnitTest {
+public:
+    OSCDecoderTests() : juce::UnitTest("OSCDecoder", "ECMapper") {}
+
+    void runTest() override {
+        testKeyForms();
+        testArgumentCounts();
+        testArgumentTypes();
+        testRanges();
+        testRecords();
+    }
+
+private:
+    using Result = OSCDecoder::Result;
+
+    static juce::OSCMessage createMessage(const juce::String &address, std::initializer_list<int> args) {
+        juce::OSCMessage message { juce::OSCAddressPattern(address) };
+        for (auto arg : args)
+            message.addInt32(arg);
+        return message;
+    }
+
+    Result decode(const juce::String &address, std::initializer_list<int> args) {
+        OSC::Message msg;
+        return OSCDecoder::decode(createMessage(address, args), msg);
+    }
+
+    static LocalLink::Record createKeyRecord() {
+        LocalLink::Record record {};
+        record.type = OSC::MessageType::Key;
+        record.course = 1;
+        record.key = 42;
+        record.active = 1;
+        record.device = (juce::int32)DeviceType::Alpha;
+        return record;
+    }
+
+    Result decode(const LocalLink::Record &record) {
+        OSC::Message msg;
+        return OSCDecoder::decode(record, msg);
+    }
+
+    void testKeyForms() {
+        beginTest("key with 7, 9 and 10 arguments");
+        OSC::Message msg;
+        expect(OSCDecoder::decode(createMessage("/EigenCore/key", { 1, 42, 1, 3000, -200, 300, 1 }), msg) == Result::Decoded);
+        expect(msg.type == OSC::MessageType::Key);
+        expectEquals((int)msg.course, 1);
+        expectEquals((int)msg.key, 42);
+        expectEquals(msg.active, 1);
+        expectEquals((int)msg.pressure, 3000);
+        expectEquals(msg.roll, -200);
+        expectEquals(msg.yaw, 300);
+        expect(msg.device == DeviceType::Alpha);
+        expectEquals((int)msg.callbackTime, 0);
+        expectEquals(msg.instance, 0);
+
+        expect(OSCDecoder::decode(createMessage("/EigenCore/key", { 2, 119, 0, 0, 0, 0, 3, 11, 22 }), msg) == Result::Decoded);
+        expect(msg.device == DeviceType::Pico);
+        expectEquals((int)msg.callbackTime, 11);
+        expectEquals((int)msg.sendTime, 22);
+        expectEquals(msg.instance, 0);
+
+        expect(OSCDecoder::decode(createMessage("/EigenCore/key", { 0, 0, 1, 0, 0, 0, 2, 11, 22, 3 }), msg) == Result::Decoded);
+        expect(msg.device == DeviceType::Tau);
+        expectEquals(msg.instance, 3);
+    }
+
+    void testArgumentCounts() {
+        beginTest("wrong argument counts");
+        for (auto count : { 0, 6, 8, 11 }) {
+            juce::OSCMessage message { juce::OSCAddressPattern("/EigenCore/key") };
+            for (int i = 0; i < count; i++)
+                message.addInt32(1);
+            OSC::Message msg;
+            expect(OSCDecoder::decode(message, msg) == Result::Rejected, "key with " + juce::String(count) + " arguments");
+        }
+        expect(decode("/EigenCore/breath", { 100 }) == Result::Rejected);
+        expect(decode("/EigenCore/breath", { 100, 1, 0, 0 }) == Result::Rejected);
+        expect(decode("/EigenCore/strip", { 1, 100, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/strip", { 1, 100, 1, 1, 0, 0 }) == Result::Rejected);
+        expect(decode("/EigenCore/pedal", { 0, 100 }) == Result::Rejected);
+        expect(decode("/EigenCore/pedal", { 0, 100, 1, 0, 0 }) == Result::Rejected);
+        expect(decode("/EigenCore/device", {}) == Result::Rejected);
+        expect(decode("/EigenCore/device", { 1, 0, 0 }) == Result::Rejected);
+
+        expect(decode("/EigenCore/breath", { 100, 1 }) == Result::Decoded);
+        expect(decode("/EigenCore/strip", { 1, 100, 1, 1, 2 }) == Result::Decoded);
+        expect(decode("/EigenCore/pedal", { 0, 100, 1 }) == Result::Decoded);
+        expect(decode("/EigenCore/device", { 3, 1 }) == Result::Decoded);
+        expect(decode("/EigenCore/ping", { 1, 2, 3 }) == Result::Unknown);
+    }
+
+    void testArgumentTypes() {
+        beginTest("non-int arguments");
+        OSC::Message msg;
+        juce::OSCMessage key { juce::OSCAddressPattern("/EigenCore/key"), 1, 42, 1, 3000.0f, -200, 300, 1 };
+        expect(OSCDecoder::decode(key, msg) == Result::Rejected);
+        juce::OSCMessage device { juce::OSCAddressPattern("/EigenCore/device"), juce::String("1") };
+        expect(OSCDecoder::decode(device, msg) == Result::Rejected);
+        juce::OSCMessage instance { juce::OSCAddressPattern("/EigenCore/breath"), 100, 1, 0.0f };
+        expect(OSCDecoder::decode(instance, msg) == Result::Rejected);
+    }
+
+    void testRanges() {
+        beginTest("course, key, strip, device and instance out of range");
+        expect(decode("/EigenCore/key", { -1, 42, 1, 0, 0, 0, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 3, 42, 1, 0, 0, 0, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 1, -1, 1, 0, 0, 0, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 1, 120, 1, 0, 0, 0, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 1, 42, 1, 0, 0, 0, 0 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 1, 42, 1, 0, 0, 0, 4 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 1, 42, 1, 0, 0, 0, 1, 0, 0, -1 }) == Result::Rejected);
+        expect(decode("/EigenCore/key", { 1, 42, 1, 0, 0, 0, 1, 0, 0, OSC::MaxInstances }) == Result::Rejected);
+        expect(decode("/EigenCore/strip", { 0, 100, 1, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/strip", { 3, 100, 1, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/pedal", { -1, 100, 1 }) == Result::Rejected);
+        expect(decode("/EigenCore/breath", { 100, 1, OSC::MaxInstances }) == Result::Rejected);
+        expect(decode("/EigenCore/device", { 0 }) == Result::Rejected);
+    }
+
+    void testRecords() {
+        beginTest("local link records");
+        OSC::Message msg;
+        auto record = createKeyRecord();
+        record.instance = OSC::MaxInstances - 1;
+        expect(OSCDecoder::decode(record, msg) == Result::Decoded);
+        expect(msg.type == OSC::MessageType::Key);
+        expectEquals((int)msg.key, 42);
+        expectEquals(msg.instance, OSC::MaxInstances - 1);
+
+        record = createKeyRecord();
+        record.course = 3;
+        expect(decode(record) == Result::Rejected);
+        record = createKeyRecord();
+        record.key = 120;
+        expect(decode(record) == Result::Rejected);
+        record = createKeyRecord();
+        record.instance = OSC::MaxInstances;
+        expect(decode(record) == Result::Rejected);
+        record = createKeyRecord();
+        record.instance = -1;
+        expect(decode(record) == Result::Rejected);
+        record = createKeyRecord();
+        record.device = (juce::int32)DeviceType::None;
+        expect(decode(record) == Result::Rejected);
+        record = createKeyRecord();
+        record.type = OSC::MessageType::LED;
+        expect(decode(record) == Result::Rejected);
+
+        record = createKeyRecord();
+        record.type = OSC::MessageType::Strip;
+        record.strip = 0;
+        expect(decode(record) == Result::Rejected);
+        record.strip = 2;
+        expect(decode(record) == Result::Decoded);
+    }
+};
+
+static OSCDecoderTests oscDecoderTests;
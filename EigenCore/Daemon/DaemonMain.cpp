@@ -0,0 +1,92 @@
+#include <JuceHeader.h>
+#include <csignal>
+#include <iostream>
+#include "../Source/Core/EigenCore.h"
+
+// Runs EigenCore without the plugin shell: no audio device, no editor, just the core and a message loop for OSC.
+// Usage: eigencore_daemon [--config <file>] [--ip 127.0.0.1:12121] [--simulator <config>] [--metrics <spec>] [--capture]
+// The config file takes the same settings as "name = value" lines, e.g. "ip = 192.168.1.20:12121".
+// Options given on the command line override the config file. SIGINT and SIGTERM shut the core down cleanly.
+
+static const char *usage = "Usage: eigencore_daemon [--config <file>] [--ip <host:port>] [--simulator <config>] [--metrics <spec>] [--capture]";
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static bool readConfigFile(const juce::File &file, juce::StringPairArray &settings) {
+    if (!file.existsAsFile()) {
+        std::cout << "Config file not found: " << file.getFullPathName() << std::endl;
+        return false;
+    }
+    
+    juce::StringArray lines;
+    file.readLines(lines);
+    for (auto line : lines) {
+        line = line.upToFirstOccurrenceOf("#", false, false).trim();
+        if (line.isEmpty())
+            continue;
+        if (!line.contains("=")) {
+            std::cout << "Ignoring config line: " << line << std::endl;
+            continue;
+        }
+        settings.set(line.upToFirstOccurrenceOf("=", false, false).trim(), line.fromFirstOccurrenceOf("=", false, false).trim());
+    }
+    return true;
+}
+
+// Stops the message loop once a signal came in. The handler itself only sets a flag.
+class SignalWatcher : private juce::Timer {
+public:
+    SignalWatcher() { startTimer(50); }
+    ~SignalWatcher() override { stopTimer(); }
+
+private:
+    void timerCallback() override {
+        if (stopRequested) {
+            stopTimer();
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")) {
+        std::cout << usage << std::endl;
+        return 0;
+    }
+    
+    juce::StringPairArray settings;
+    if (args.containsOption("--config") && !readConfigFile(args.getFileForOption("--config"), settings))
+        return 1;
+    for (auto name : { "ip", "simulator", "metrics" }) {
+        auto option = juce::String("--") + name;
+        if (args.containsOption(option))
+            settings.set(name, args.getValueForOption(option));
+    }
+    if (args.containsOption("--capture"))
+        settings.set("capture", "1");
+    
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    {
+        EigenCore eigenCore(settings["simulator"], settings["metrics"]);
+        if (!eigenCore.initialiseCore(settings["ip"])) {
+            std::cout << "EigenCore failed to start" << std::endl;
+            return 1;
+        }
+        if (settings["capture"].getIntValue() != 0)
+            eigenCore.startCapture();
+        
+        SignalWatcher signalWatcher;
+        juce::MessageManager::getInstance()->runDispatchLoop();
+        
+        eigenCore.shutdownCore();
+    }
+    return 0;
+}
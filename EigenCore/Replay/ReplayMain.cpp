@@ -0,0 +1,105 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <thread>
+#include "EventCapture.h"
+
+// Plays an EigenCore capture file back to ECMapper over OSC, using the same messages EigenCore sends.
+// Usage: eigencore_replay --file <capture.ecap> [--host 127.0.0.1] [--port 12121[,12122...]] [--instance 0] [--speed 1.0] [--loop]
+// --speed 0 sends as fast as possible. Every port gets the whole capture, as if each ECMapper instance listening
+// there had subscribed to everything. --instance is the instrument instance the capture is played as, captures
+// don't record it. The pings carry no process id, so ECMapper stays on OSC instead of looking for a local link.
+
+static const int maxInstances = 4; // ECMapper's OSC::MaxInstances, it rejects higher instances
+
+static void sendRecord(juce::OSCSender &sender, const EventCapture::Record &record, int instance) {
+    switch (record.type) {
+        case EventCapture::Key:
+            // no callback and send time, the latency trace skips replayed keys
+            sender.send("/EigenCore/key", (int)record.course, (int)record.index, (int)record.active, (int)record.value, (int)record.roll, (int)record.yaw, (int)record.device, 0, 0, instance);
+            break;
+        case EventCapture::Breath:
+            sender.send("/EigenCore/breath", (int)record.value, (int)record.device, instance);
+            break;
+        case EventCapture::Strip:
+            sender.send("/EigenCore/strip", (int)record.index, (int)record.value, (int)record.active, (int)record.device, instance);
+            break;
+        case EventCapture::Pedal:
+            sender.send("/EigenCore/pedal", (int)record.index, (int)record.value, (int)record.device, instance);
+            break;
+        case EventCapture::Device:
+            sender.send("/EigenCore/device", (int)record.device, instance);
+            break;
+        default:
+            break;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+    if (!args.containsOption("--file")) {
+        std::cout << "Usage: eigencore_replay --file <capture.ecap> [--host 127.0.0.1] [--port 12121[,12122...]] [--instance 0] [--speed 1.0] [--loop]" << std::endl;
+        return 1;
+    }
+    
+    auto file = args.getExistingFileForOption("--file");
+    auto host = args.containsOption("--host") ? args.getValueForOption("--host") : juce::String("127.0.0.1");
+    auto ports = juce::StringArray::fromTokens(args.containsOption("--port") ? args.getValueForOption("--port") : juce::String("12121"), ",", "");
+    int instance = args.containsOption("--instance") ? args.getValueForOption("--instance").getIntValue() : 0;
+    double speed = args.containsOption("--speed") ? args.getValueForOption("--speed").getDoubleValue() : 1.0;
+    bool loop = args.containsOption("--loop");
+    
+    if (instance < 0 || instance >= maxInstances) {
+        std::cout << "--instance must be 0 to " << maxInstances - 1 << std::endl;
+        return 1;
+    }
+    
+    std::vector<std::unique_ptr<juce::OSCSender>> senders;
+    for (auto &port : ports) {
+        senders.push_back(std::make_unique<juce::OSCSender>());
+        if (!senders.back()->connect(host, port.getIntValue())) {
+            std::cout << "Unable to connect to " << host << ":" << port << std::endl;
+            return 1;
+        }
+    }
+    
+    do {
+        EventCapture::Reader reader;
+        if (!reader.open(file)) {
+            std::cout << "Not a valid capture file: " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+        
+        EventCapture::Record record;
+        juce::int64 recordCount = 0;
+        auto startTime = juce::Time::getMillisecondCounterHiRes();
+        auto lastPing = 0.0;
+        while (reader.read(record)) {
+            if (speed > 0.0) {
+                auto due = startTime + record.captureTime/(1000.0*speed);
+                auto now = juce::Time::getMillisecondCounterHiRes();
+                if (due > now)
+                    std::this_thread::sleep_for(std::chrono::microseconds((juce::int64)((due - now)*1000.0)));
+            }
+            
+            // keeps ECMapper's connection state alive like EigenCore's ping timer does
+            auto now = juce::Time::getMillisecondCounterHiRes();
+            if (now - lastPing > 100.0) {
+                for (auto &sender : senders)
+                    sender->send("/EigenCore/ping");
+                lastPing = now;
+            }
+            
+            for (auto &sender : senders)
+                sendRecord(*sender, record, instance);
+            recordCount++;
+        }
+        
+        auto elapsed = (juce::Time::getMillisecondCounterHiRes() - startTime)/1000.0;
+        std::cout << "Replayed " << recordCount << " records in " << elapsed << " s" << std::endl;
+    } while (loop);
+    
+    for (auto &sender : senders)
+        sender->disconnect();
+    return 0;
+}
@@ -1,44 +1,44 @@
 #include "APICallback.h"
 
-APICallback::APICallback(EigenApi::Eigenharp& eh, OSC::OSCMessageFifo *sendQueue) : eh_(eh)
+APICallback::APICallback(DeviceBackend& eh, OSC::OSCMessageFifo *sendQueue, OSCCommunication *osc, CaptureRecorder *recorder, Metrics::Counter &devicesRefused) : eh_(eh), devicesRefused(devicesRefused)
 {
     this->sendQueue = sendQueue;
+    this->osc = osc;
+    this->recorder = recorder;
 }
 
 void APICallback::disconnect(const char *dev, DeviceType dt)
 {
-    for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
-        if (i->dev == dev) {
-            connectedDevices.erase(i);
-        }
-    }
+    auto device = findDevice(dev);
+    capture(EventCapture::Disconnect, device == nullptr ? EHDeviceType::None : device->type, 0, 0, 0, false, 0, 0, 0);
+    connectedDevices.remove_if([dev](const ConnectedDevice &device) { return device.dev == dev; });
 }
 
 void APICallback::device(const char* dev, DeviceType dt, int rows, int cols, int ribbons, int pedals)
 {
-    EHDeviceType devType;
-    switch(cols) {
-        case 2:
-            devType = EHDeviceType::Pico;
-            break;
-        case 4:
-            devType = EHDeviceType::Tau;
-            break;
-        case 5:
-            devType = EHDeviceType::Alpha;
-            break;
-        default:
-            devType = EHDeviceType::None;
-            break;
-    }
-    ConnectedDevice newDev { .dev = dev, .type = devType };
-    for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
-        if (i->type == newDev.type) {
-            connectedDevices.erase(i);
+    auto devType = (EHDeviceType)DeviceGeometry::deviceTypeForCols(cols);
+    // the same instrument again replaces its old entry, another one of the same type gets the lowest free instance
+    connectedDevices.remove_if([dev](const ConnectedDevice &device) { return device.dev == dev; });
+    int instance = 0;
+    for (bool taken = true; taken && instance < OSC::MaxInstances; ) {
+        taken = false;
+        for (auto &device : connectedDevices) {
+            if (device.type == devType && device.instance == instance) {
+                taken = true;
+                instance++;
+            }
         }
     }
+    // ECMapper drops everything from higher instances, so the instrument is not used at all
+    if (instance >= OSC::MaxInstances) {
+        std::cout << "Device " << dev << " refused, " << OSC::MaxInstances << " instruments of its type are connected already" << std::endl;
+        devicesRefused.add();
+        return;
+    }
     
+    ConnectedDevice newDev { .dev = dev, .type = devType, .instance = instance };
     connectedDevices.push_back(newDev);
+    capture(EventCapture::Device, devType, 0, 0, 0, false, 0, 0, 0);
     
     OSC::Message msg {
         .type = OSC::MessageType::Device,
@@ -51,9 +51,10 @@ void APICallback::device(const char* dev, DeviceType dt, int rows, int cols, int
         .value = 0,
         .pedal = 0,
         .strip = 0,
-        .device = devType
+        .device = devType,
+        .instance = instance
     };
-    sendQueue->add(&msg);
+    send(msg);
 }
 
 void APICallback::key(const char* dev, unsigned long long t, unsigned course, unsigned key, bool a, unsigned p, int r, int y) {
@@ -64,15 +65,20 @@ void APICallback::key(const char* dev, unsigned long long t, unsigned course, un
 
     for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
         if (i->dev == dev) {
-            if (a && !i->activeKeys[course][key]) {
-                i->activeKeys[course][key] = true;
+            int index = DeviceGeometry::keyIndex((int)i->type, course, key);
+            if (index < 0)
+                return;
+            bool transition = a != i->activeKeys[index];
+            if (a && !i->activeKeys[index]) {
+                i->activeKeys[index] = true;
                 eh_.setLED(dev, course, key, 3);
             }
             else if (!a) {
-                i->activeKeys[course][key] = false;
-                eh_.setLED(dev, course, key, i->assignedLEDColours[course][key]);
+                i->activeKeys[index] = false;
+                eh_.setLED(dev, course, key, i->assignedLEDColours[index]);
             }
             
+            capture(EventCapture::Key, i->type, t, course, key, a, p, r, y);
             OSC::Message msg {
                 .type = OSC::MessageType::Key,
                 .key = key,
@@ -84,9 +90,12 @@ void APICallback::key(const char* dev, unsigned long long t, unsigned course, un
                 .value = 0,
                 .pedal = 0,
                 .strip = 0,
-                .device = i->type
+                .device = i->type,
+                .callbackTime = LatencyTrace::nowMicros(),
+                .transition = transition,
+                .instance = i->instance
             };
-            sendQueue->add(&msg);
+            send(msg);
             
             break;
         }
@@ -94,6 +103,11 @@ void APICallback::key(const char* dev, unsigned long long t, unsigned course, un
 }
 
 void APICallback::breath(const char* dev, unsigned long long t, unsigned val) {
+    auto device = findDevice(dev);
+    if (device == nullptr)
+        return;
+    
+    capture(EventCapture::Breath, device->type, t, 0, 0, false, val, 0, 0);
     OSC::Message msg {
         .type = OSC::MessageType::Breath,
         .key = 0,
@@ -105,13 +119,19 @@ void APICallback::breath(const char* dev, unsigned long long t, unsigned val) {
         .value = val,
         .pedal = 0,
         .strip = 0,
-        .device = getTypeFromDev(dev)
+        .device = device->type,
+        .instance = device->instance
     };
-    sendQueue->add(&msg);
+    send(msg);
 }
 
 void APICallback::strip(const char* dev, unsigned long long t, unsigned strip, unsigned val, bool a) {
     //std::cout  << "strip " << dev << " @ " << t << " - " << strip << ":" << val << ' ' << a << std::endl;
+    auto device = findDevice(dev);
+    if (device == nullptr)
+        return;
+    
+    capture(EventCapture::Strip, device->type, t, 0, strip, a, val, 0, 0);
     OSC::Message msg {
         .type = OSC::MessageType::Strip,
         .key = 0,
@@ -123,12 +143,18 @@ void APICallback::strip(const char* dev, unsigned long long t, unsigned strip, u
         .value = val,
         .pedal = 0,
         .strip = strip,
-        .device = getTypeFromDev(dev)
+        .device = device->type,
+        .instance = device->instance
     };
-    sendQueue->add(&msg);
+    send(msg);
 }
 
 void APICallback::pedal(const char* dev, unsigned long long t, unsigned pedal, unsigned val) {
+    auto device = findDevice(dev);
+    if (device == nullptr)
+        return;
+    
+    capture(EventCapture::Pedal, device->type, t, 0, pedal, false, val, 0, 0);
     OSC::Message msg {
         .type = OSC::MessageType::Pedal,
         .key = 0,
@@ -140,15 +166,61 @@ void APICallback::pedal(const char* dev, unsigned long long t, unsigned pedal, u
         .value = val,
         .pedal = pedal,
         .strip = 0,
-        .device = getTypeFromDev(dev)
+        .device = device->type,
+        .instance = device->instance
     };
-    sendQueue->add(&msg);
+    send(msg);
 }
 
-EHDeviceType APICallback::getTypeFromDev(const char* dev) const {
-    for (auto device : connectedDevices) {
+void APICallback::send(const OSC::Message &msg) {
+    // nothing any subscriber maps, dropped before it costs a record or a datagram
+    if (!osc->isWanted(msg))
+        return;
+    
+    // straight into the shared memory ring when an ECMapper on this machine is attached,
+    // through OSC as well when other subscribers need it
+    LocalLink::Record record {
+        .type = (juce::int32)msg.type,
+        .course = msg.course,
+        .key = msg.key,
+        .active = msg.active,
+        .pressure = msg.pressure,
+        .roll = msg.roll,
+        .yaw = msg.yaw,
+        .strip = msg.strip,
+        .pedal = msg.pedal,
+        .value = msg.value,
+        .device = (juce::int32)msg.device,
+        .callbackTime = msg.callbackTime,
+        .sendTime = msg.type == OSC::MessageType::Key ? LatencyTrace::nowMicros() : 0,
+        .instance = msg.instance
+    };
+    if (!osc->getLocalLink()->send(record) || osc->needsUDP())
+        sendQueue->add(&msg);
+}
+
+const ConnectedDevice* APICallback::findDevice(const char* dev) const {
+    for (auto &device : connectedDevices) {
         if (device.dev == dev)
-            return device.type;
+            return &device;
     }
-    return EHDeviceType::None;
+    return nullptr;
+}
+
+void APICallback::capture(EventCapture::EventType type, EHDeviceType deviceType, unsigned long long t, unsigned course, unsigned index, bool active, unsigned value, int roll, int yaw) {
+    if (recorder == nullptr || !recorder->isRecording())
+        return;
+    
+    EventCapture::Record record {
+        .eigenTime = t,
+        .type = (juce::uint8)type,
+        .device = (juce::uint8)deviceType,
+        .course = (juce::uint8)course,
+        .active = (juce::uint8)active,
+        .index = index,
+        .value = value,
+        .roll = roll,
+        .yaw = yaw
+    };
+    recorder->add(record);
 }
@@ -9,10 +9,14 @@
 #include "OSCCommunication.h"
 #include "Enums.h"
 #include "Common.h"
+#include "CaptureRecorder.h"
+#include "DeviceBackend.h"
+#include "LatencyTrace.h"
+#include "LocalLink.h"
 
 class APICallback: public EigenApi::Callback {
 public:
-    APICallback(EigenApi::Eigenharp& eh, OSC::OSCMessageFifo *sendQueue);
+    APICallback(DeviceBackend& eh, OSC::OSCMessageFifo *sendQueue, OSCCommunication *osc, CaptureRecorder *recorder, Metrics::Counter &devicesRefused);
     virtual void device(const char* dev, DeviceType dt, int rows, int cols, int ribbons, int pedals);
     virtual void disconnect(const char* dev, DeviceType dt);
     virtual void key(const char* dev, unsigned long long t, unsigned course, unsigned key, bool a, unsigned p, int r, int y);
@@ -20,9 +24,14 @@ public:
     virtual void strip(const char* dev, unsigned long long t, unsigned strip, unsigned val, bool a);
     virtual void pedal(const char* dev, unsigned long long t, unsigned pedal, unsigned val);
     
-    EigenApi::Eigenharp& eh_;
+    DeviceBackend& eh_;
 
 private:
     OSC::OSCMessageFifo *sendQueue;
-    EHDeviceType getTypeFromDev(const char* dev) const;
+    OSCCommunication *osc;
+    CaptureRecorder *recorder;
+    Metrics::Counter &devicesRefused;
+    void send(const OSC::Message &msg);
+    const ConnectedDevice* findDevice(const char* dev) const;
+    void capture(EventCapture::EventType type, EHDeviceType deviceType, unsigned long long t, unsigned course, unsigned index, bool active, unsigned value, int roll, int yaw);
 };
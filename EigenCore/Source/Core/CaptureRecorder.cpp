@@ -0,0 +1,67 @@
+#include "CaptureRecorder.h"
+
+CaptureRecorder::CaptureRecorder() : juce::Thread("EigenCore capture") {
+}
+
+CaptureRecorder::~CaptureRecorder() {
+    stop();
+}
+
+bool CaptureRecorder::start(const juce::File &file) {
+    if (recording)
+        return true;
+    
+    if (!writer.open(file)) {
+        std::cout << "Unable to open capture file: " << file.getFullPathName() << std::endl;
+        return false;
+    }
+    fifo.reset();
+    droppedRecords = 0;
+    startTime = (juce::uint32)(juce::Time::getMillisecondCounterHiRes()*1000.0);
+    startThread();
+    recording = true;
+    std::cout << "Capturing to: " << file.getFullPathName() << std::endl;
+    return true;
+}
+
+void CaptureRecorder::stop() {
+    if (!recording)
+        return;
+    
+    recording = false;
+    stopThread(1000);
+    writePending();
+    std::cout << "Capture stopped, " << writer.getRecordCount() << " records written, " << droppedRecords << " dropped" << std::endl;
+    writer.close();
+}
+
+void CaptureRecorder::add(EventCapture::Record &record) {
+    if (!recording)
+        return;
+    
+    record.captureTime = (juce::uint32)(juce::Time::getMillisecondCounterHiRes()*1000.0) - startTime;
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 > 0)
+        buffer[start1] = record;
+    else
+        droppedRecords++;
+    fifo.finishedWrite(size1);
+}
+
+void CaptureRecorder::run() {
+    while (!threadShouldExit()) {
+        writePending();
+        wait(5);
+    }
+}
+
+void CaptureRecorder::writePending() {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1; i++)
+        writer.write(buffer[start1 + i]);
+    for (int i = 0; i < size2; i++)
+        writer.write(buffer[start2 + i]);
+    fifo.finishedRead(size1 + size2);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <JuceHeader.h>
+#include <iostream>
+#include "EventCapture.h"
+
+#define CAPTURE_QUEUE_SIZE 16384
+
+// Collects EventCapture records from the EigenLite callbacks and writes them to disk on its own thread,
+// so the eigenharpProcess loop never waits for file IO.
+class CaptureRecorder : private juce::Thread {
+public:
+    CaptureRecorder();
+    ~CaptureRecorder();
+    bool start(const juce::File &file);
+    void stop();
+    bool isRecording() const { return recording; }
+    int getDroppedCount() const { return droppedRecords; }
+    void add(EventCapture::Record &record);
+    
+private:
+    void run() override;
+    void writePending();
+    
+    std::atomic<bool> recording { false };
+    std::atomic<int> droppedRecords { 0 };
+    juce::uint32 startTime = 0;
+    juce::AbstractFifo fifo { CAPTURE_QUEUE_SIZE };
+    EventCapture::Record buffer[CAPTURE_QUEUE_SIZE];
+    EventCapture::Writer writer;
+};
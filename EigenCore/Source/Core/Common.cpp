@@ -0,0 +1,6 @@
+#include <JuceHeader.h>
+#include "Common.h"
+
+volatile std::atomic<bool> exitThreads;
+std::atomic<bool> mapperConnected;
+std::list<ConnectedDevice> connectedDevices;
@@ -1,10 +1,12 @@
 #pragma once
 #include "Enums.h"
+#include "DeviceGeometry.h"
 struct ConnectedDevice {
     const char *dev;
     EHDeviceType type = EHDeviceType::None;
-    int assignedLEDColours[3][120]; // course, key
-    bool activeKeys[3][120]; // course, key
+    int instance = 0; // 0 for the first instrument of its type, counting up for more of the same type at once
+    int assignedLEDColours[DeviceGeometry::MaxKeys]; // by DeviceGeometry::keyIndex()
+    bool activeKeys[DeviceGeometry::MaxKeys];
 };
 extern std::list<ConnectedDevice> connectedDevices;
 extern volatile std::atomic<bool> exitThreads;
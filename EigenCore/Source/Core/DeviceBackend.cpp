@@ -0,0 +1,33 @@
+#include "DeviceBackend.h"
+
+EigenLiteBackend::EigenLiteBackend() : eigenApi(fwReader) {
+}
+
+bool EigenLiteBackend::confirmResources() {
+    return fwReader.confirmResources();
+}
+
+bool EigenLiteBackend::start() {
+    return eigenApi.start();
+}
+
+void EigenLiteBackend::stop() {
+    eigenApi.stop();
+}
+
+bool EigenLiteBackend::process() {
+    return eigenApi.process();
+}
+
+void EigenLiteBackend::setPollTime(unsigned pollTime) {
+    eigenApi.setPollTime(pollTime);
+}
+
+void EigenLiteBackend::addCallback(EigenApi::Callback *callback) {
+    eigenApi.addCallback(callback);
+}
+
+void EigenLiteBackend::setLED(const char *dev, unsigned course, unsigned key, unsigned colour) {
+    ledWrites.fetch_add(1, std::memory_order_relaxed);
+    eigenApi.setLED(dev, course, key, colour);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <JuceHeader.h>
+#include <eigenapi.h>
+#include "FirmwareReader.h"
+
+// The part of EigenLite that EigenCore talks to. Lets the core run against real hardware or a simulator.
+class DeviceBackend {
+public:
+    virtual ~DeviceBackend() {}
+    virtual bool confirmResources() { return true; }
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual bool process() = 0;
+    virtual void setPollTime(unsigned pollTime) = 0;
+    virtual void addCallback(EigenApi::Callback *callback) = 0;
+    virtual void setLED(const char *dev, unsigned course, unsigned key, unsigned colour) = 0;
+    juce::int64 getLEDWriteCount() const { return ledWrites.load(std::memory_order_relaxed); }
+
+protected:
+    std::atomic<juce::int64> ledWrites { 0 };
+};
+
+class EigenLiteBackend : public DeviceBackend {
+public:
+    EigenLiteBackend();
+    bool confirmResources() override;
+    bool start() override;
+    void stop() override;
+    bool process() override;
+    void setPollTime(unsigned pollTime) override;
+    void addCallback(EigenApi::Callback *callback) override;
+    void setLED(const char *dev, unsigned course, unsigned key, unsigned colour) override;
+
+private:
+    FWR_InMem fwReader;
+    EigenApi::Eigenharp eigenApi;
+};
@@ -1,26 +1,45 @@
 #include "EigenCore.h"
 
-EigenCore::EigenCore() : eigenApi(fwReader), osc(&oscSendQueue, &oscReceiveQueue) {
+// EIGENCORE_SIMULATOR replaces the instruments with generated traffic, see SimulatedBackend.h
+EigenCore::EigenCore() : EigenCore(juce::SystemStats::getEnvironmentVariable("EIGENCORE_SIMULATOR", ""), juce::SystemStats::getEnvironmentVariable("EIGENCORE_METRICS", "")) {
+}
+
+EigenCore::EigenCore(const juce::String &simulatorConfig, const juce::String &metricsExport) : processLoopTime(metrics.addHistogram("process_loop")), devicesRefused(metrics.addCounter("devices_refused")), osc(&oscSendQueue, &oscReceiveQueue, &latencyTrace, metrics) {
     jassert(coreInstance == nullptr);
     coreInstance = this;
     std::cout << "EigenCore v1.0.3" << std::endl;
+    
+    if (simulatorConfig.isNotEmpty())
+        eigenApi = new SimulatedBackend(simulatorConfig);
+    else
+        eigenApi = new EigenLiteBackend();
+    
+    metrics.addGauge("send_queue", [this] { return (juce::int64)oscSendQueue.getMessageCount(); });
+    metrics.addCounter("send_overflows", [this] { return oscSendQueue.getOverflowCount(); });
+    metrics.addGauge("receive_queue", [this] { return (juce::int64)oscReceiveQueue.getMessageCount(); });
+    metrics.addCounter("receive_overflows", [this] { return oscReceiveQueue.getOverflowCount(); });
+    metrics.addCounter("led_writes", [this] { return eigenApi->getLEDWriteCount(); });
+    metrics.addGauge("capture_dropped", [this] { return (juce::int64)captureRecorder.getDroppedCount(); });
+    metricsSampler = std::make_unique<Metrics::Sampler>(metrics, metricsExport);
 }
 
 EigenCore::~EigenCore() {
+    metricsSampler = nullptr;
     if (apiCallback != nullptr)
         delete apiCallback;
+    delete eigenApi;
 }
 
-void EigenCore::initialiseCore(juce::String ipString) {
+bool EigenCore::initialiseCore(juce::String ipString) {
     if (running)
-        return;
+        return true;
     
-    running = true;
-    exitThreads = false;
-    if (!fwReader.confirmResources()) {
+    if (!eigenApi->confirmResources()) {
         std::cout << "IHX files not properly configured." << std::endl;
-        return;
+        return false;
     }
+    running = true;
+    exitThreads = false;
     
     if (ipString == "")
         ipString = defaultIP;
@@ -35,15 +54,16 @@ void EigenCore::initialiseCore(juce::String ipString) {
     }
     
     if (!exitThreads) {
-        eigenApi.setPollTime(EIGENAPI_POLLTIME);
-        apiCallback = new APICallback(eigenApi, &oscSendQueue);
-        eigenApi.addCallback(apiCallback);
-        if(!eigenApi.start()) {
+        eigenApi->setPollTime(EIGENAPI_POLLTIME);
+        apiCallback = new APICallback(*eigenApi, &oscSendQueue, &osc, &captureRecorder, devicesRefused);
+        eigenApi->addCallback(apiCallback);
+        if(!eigenApi->start()) {
             std::cout << "Unable to start EigenLite" << std::endl;
         }
         
-        eigenApiProcessThread = std::thread(coreInstance->eigenharpProcess, &oscReceiveQueue, &eigenApi);
+        eigenApiProcessThread = std::thread(coreInstance->eigenharpProcess, &oscReceiveQueue, eigenApi, &processLoopTime);
     }
+    return true;
 }
 
 void EigenCore::shutdownCore() {
@@ -52,7 +72,8 @@ void EigenCore::shutdownCore() {
     
     running = false;
     std::cout << "Shutting down..." << std::endl;
-    turnOffAllLEDs(&eigenApi);
+    captureRecorder.stop();
+    turnOffAllLEDs(eigenApi);
     osc.disconnectReceiver();
     osc.disconnectSender();
     sleep(1);
@@ -60,7 +81,7 @@ void EigenCore::shutdownCore() {
     sleep(1);
     if (eigenApiProcessThread.joinable())
         eigenApiProcessThread.join();
-    eigenApi.stop();
+    eigenApi->stop();
     
     if (apiCallback != nullptr) {
         delete apiCallback;
@@ -69,65 +90,35 @@ void EigenCore::shutdownCore() {
 }
 
 void EigenCore::turnOffAllLEDs() {
-    turnOffAllLEDs(&eigenApi);
+    turnOffAllLEDs(eigenApi);
 }
 
-void EigenCore::turnOffAllLEDs(EigenApi::Eigenharp *api) {
+void EigenCore::turnOffAllLEDs(DeviceBackend *api) {
     for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
         turnOffAllLEDsForDevice(*i, api);
     }
 }
 
-void EigenCore::turnOffAllLEDsForDevice(ConnectedDevice &device, EigenApi::Eigenharp *api) {
-    int course0Length = 0;
-    int course1Start = 0;
-    int course1Length = 0;
-    switch (device.type) {
-        case EHDeviceType::Pico:
-            course0Length = 18;
-            course1Length = 4;
-            break;
-        case EHDeviceType::Tau:
-            course0Length = 72 + 12;
-            course1Length = 8;
-            course1Start = 5;
-            break;
-        case EHDeviceType::Alpha:
-            course0Length = 120;
-            course1Length = 12;
-            break;
-        default:
-            break;
-    }
-
-    for (int i = 0; i < course0Length; i++) {
-        try {
-            api->setLED(device.dev, 0, i, 0);
-        } catch (...) {
-            std::cout << "Set LED failed: device " << device.dev << " course 0 key " << i << std::endl;
-        }
-        device.assignedLEDColours[0][i] = 0;
-        device.activeKeys[0][i] = false;
-    }
-    for (int i = course1Start; i < course1Start + course1Length; i++) {
+void EigenCore::turnOffAllLEDsForDevice(ConnectedDevice &device, DeviceBackend *api) {
+    int deviceType = (int)device.type;
+    for (int i = 0; i < DeviceGeometry::keyCount(deviceType); i++) {
+        int course = DeviceGeometry::courseOf(deviceType, i);
+        int key = DeviceGeometry::keyOf(deviceType, i);
         try {
-            api->setLED(device.dev, 1, i, 0);
+            api->setLED(device.dev, course, key, 0);
         } catch (...) {
-            std::cout << "Set LED failed: device " << device.dev << " course 1 key " << i << std::endl;
+            std::cout << "Set LED failed: device " << device.dev << " course " << course << " key " << key << std::endl;
         }
-        device.assignedLEDColours[1][i] = 0;
-        device.activeKeys[1][i] = false;
+        device.assignedLEDColours[i] = 0;
+        device.activeKeys[i] = false;
     }
 }
 
-void* EigenCore::eigenharpProcess(OSC::OSCMessageFifo *msgQueue, void* arg) {
-    EigenApi::Eigenharp *pE = static_cast<EigenApi::Eigenharp*>(arg);
+void* EigenCore::eigenharpProcess(OSC::OSCMessageFifo *msgQueue, void* arg, LatencyHistogram *loopTime) {
+    DeviceBackend *pE = static_cast<DeviceBackend*>(arg);
+    SpanTrace::setThreadName("eigenharpProcess");
     while(!exitThreads) {
-
-#ifdef MEASURE_EIGENAPIPROCESSTIME
-        static int counter = 0;
-        auto begin = std::chrono::high_resolution_clock::now();
-#endif
+        auto loopStart = LatencyTrace::nowMicros();
         static bool prevMapperConnectedState = false;
         if (mapperConnected != prevMapperConnectedState) {
             if (mapperConnected == false)
@@ -137,6 +128,7 @@ void* EigenCore::eigenharpProcess(OSC::OSCMessageFifo *msgQueue, void* arg) {
         
 //        if (mapperConnected) {
             try {
+                TRACE_SPAN("EigenLite process");
                 pE->process();
             }
             catch (...) {
@@ -144,39 +136,31 @@ void* EigenCore::eigenharpProcess(OSC::OSCMessageFifo *msgQueue, void* arg) {
             }
             static OSC::Message msg;
             while (msgQueue->getMessageCount() > 0) {
+                TRACE_SPAN("ECMapper message");
                 msgQueue->read(&msg);
                 if (msg.type == OSC::MessageType::LED) {
                     for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
-                        if (msg.device == i->type) {
-                            i->assignedLEDColours[msg.course][msg.key] = msg.value;
+                        int index = DeviceGeometry::keyIndex((int)i->type, msg.course, msg.key);
+                        if (msg.device == i->type && (msg.instance == OSC::AllInstances || msg.instance == i->instance) && index >= 0) {
+                            i->assignedLEDColours[index] = msg.value;
                             try {
                                 pE->setLED(i->dev, msg.course, msg.key, msg.value);
                             }
                             catch (...) {
                                 std::cout << "Tried to SetLED because of LED OSC msg, but got an exception." << std::endl;
                             }
-                            break;
                         }
                     }
                 }
                 else if (msg.type == OSC::MessageType::Reset) {
                     for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
-                        if (msg.device == i->type) {
+                        if (msg.device == i->type)
                             turnOffAllLEDsForDevice(*i, pE);
-                            break;
-                        }
                     }
                 }
             }
 //        }
-        
-#ifdef MEASURE_EIGENAPIPROCESSTIME
-        auto end = std::chrono::high_resolution_clock::now();
-        if (counter%1000 == 0) {
-            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin);
-            std::cout << "EigenharpProcess time: " << elapsed.count() << std::endl;
-        }
-#endif
+        loopTime->add(LatencyTrace::nowMicros() - loopStart);
         
         std::this_thread::sleep_for(std::chrono::microseconds(PROCESS_MICROSEC_SLEEP));
 //        std::this_thread::sleep_for(std::chrono::microseconds(PROCESS_MICROSEC_SLEEP + 100000*!mapperConnected));
@@ -191,3 +175,17 @@ void EigenCore::splitString(const juce::String &text, const juce::String &separa
 bool EigenCore::isRunning() {
     return running;
 }
+
+bool EigenCore::startCapture() {
+    auto captureDir = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("EigenCoreCaptures");
+    auto fileName = "capture_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + EventCapture::fileExtension;
+    return captureRecorder.start(captureDir.getChildFile(fileName));
+}
+
+void EigenCore::stopCapture() {
+    captureRecorder.stop();
+}
+
+bool EigenCore::isCapturing() const {
+    return captureRecorder.isRecording();
+}
@@ -9,38 +9,56 @@
 #include "Enums.h"
 #include "Common.h"
 #include "FirmwareReader.h"
+#include "CaptureRecorder.h"
+#include "DeviceBackend.h"
+#include "SimulatedBackend.h"
+#include "Metrics.h"
+#include "SpanTrace.h"
 
 #define PROCESS_MICROSEC_SLEEP 100
-//#define MEASURE_EIGENAPIPROCESSTIME
 #define EIGENAPI_POLLTIME 100
 
 
 class EigenCore {
 public:
     EigenCore();
+    // simulatorConfig as in EIGENCORE_SIMULATOR, metricsExport as in EIGENCORE_METRICS
+    EigenCore(const juce::String &simulatorConfig, const juce::String &metricsExport);
     ~EigenCore();
-    void initialiseCore(juce::String ipString = "");
+    // false when the firmware files are missing, the core is not running then
+    bool initialiseCore(juce::String ipString = "");
     void shutdownCore();
     bool isRunning();
     
     void turnOffAllLEDs();
-    static void turnOffAllLEDs(EigenApi::Eigenharp *api);
-    static void turnOffAllLEDsForDevice(ConnectedDevice &device, EigenApi::Eigenharp *api);
+    static void turnOffAllLEDs(DeviceBackend *api);
+    static void turnOffAllLEDsForDevice(ConnectedDevice &device, DeviceBackend *api);
+    
+    bool startCapture();
+    void stopCapture();
+    bool isCapturing() const;
+    LatencyTrace& getLatencyTrace() { return latencyTrace; }
+    juce::String getMetricsSummary() const { return metricsSampler->getSummary(); }
 
 private:
     bool running = false;
-    FWR_InMem fwReader;
-    EigenApi::Eigenharp eigenApi;
+    DeviceBackend *eigenApi = nullptr;
+    LatencyTrace latencyTrace;
+    Metrics::Registry metrics { "eigencore" };
+    LatencyHistogram &processLoopTime;
+    Metrics::Counter &devicesRefused;
     OSCCommunication osc;
     std::thread eigenApiProcessThread;
-    static void* eigenharpProcess(OSC::OSCMessageFifo *msgQueue, void* arg);
+    static void* eigenharpProcess(OSC::OSCMessageFifo *msgQueue, void* arg, LatencyHistogram *loopTime);
     void splitString(const juce::String &text, const juce::String &separator, juce::StringArray &tokens);
     
     const juce::String defaultIP = "127.0.0.1:12121";
     
     APICallback *apiCallback = nullptr;
+    CaptureRecorder captureRecorder;
     OSC::OSCMessageFifo oscSendQueue;
     OSC::OSCMessageFifo oscReceiveQueue;
+    std::unique_ptr<Metrics::Sampler> metricsSampler;
 };
 
 static EigenCore *coreInstance = nullptr;
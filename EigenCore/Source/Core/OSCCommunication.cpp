@@ -1,9 +1,23 @@
 #include "OSCCommunication.h"
 
-OSCCommunication::OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue) {
+static bool allInt32(const juce::OSCMessage &message) {
+    for (int i = 0; i < message.size(); i++) {
+        if (!message[i].isInt32())
+            return false;
+    }
+    return true;
+}
+
+OSCCommunication::OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue, LatencyTrace *latencyTrace, Metrics::Registry &metrics)
+    : messagesSent(metrics.addCounter("osc_sent")), messagesDropped(metrics.addCounter("osc_dropped")), pingTimeouts(metrics.addCounter("ping_timeouts")), messagesRejected(metrics.addCounter("osc_rejected")), messagesFiltered(metrics.addCounter("osc_filtered")), subscribersRejected(metrics.addCounter("subscribers_rejected")), echoProbe(metrics) {
+    metrics.addGauge("subscribers", [this] { return (juce::int64)subscriberCount.load(); });
+    metrics.addGauge("local_link", [this] { return (juce::int64)localLink.hasConsumer(); });
+    metrics.addCounter("local_dropped", [this] { return localLink.getDroppedCount(); });
+    metrics.addCounter("local_sent", [this] { return localLink.getSentCount(); });
 
     this->sendQueue = sendQueue;
     this->receiveQueue = receiveQueue;
+    this->latencyTrace = latencyTrace;
     receiver.addListener(this);
     receiver.registerFormatErrorHandler([this](const char *data, int dataSize) {
         std::cout << "invalid OSC data";
@@ -18,7 +32,6 @@ OSCCommunication::~OSCCommunication() {
     sendProcessThread.join();
     
     stopTimer();
-    sender.disconnect();
     receiver.disconnect();
 }
 
@@ -28,15 +41,137 @@ bool OSCCommunication::connectSender(juce::String ip, int port)  {
     std::cout << "Connecting to: " << senderIP << std::endl;
     std::cout << "Transmitting on port: " << senderPort << std::endl;
     senderConnected = true;
-    return sender.connect(senderIP, senderPort);
+    // an ECMapper on this machine listening on the port can attach to this instead of parsing our UDP
+    localLink.open(senderPort);
+    return true;
 }
 
 void OSCCommunication::disconnectSender() {
-    sender.disconnect();
+    localLink.close();
+    const juce::ScopedLock lock(subscriberLock);
+    for (auto &subscriber : subscribers) {
+        if (subscriber.port != -1)
+            removeSubscriber(subscriber);
+    }
+    updateSubscriberState();
     senderConnected = false;
     senderPort = -1;
 }
 
+OSCCommunication::Subscriber* OSCCommunication::findSubscriber(int port) {
+    for (auto &subscriber : subscribers) {
+        if (subscriber.port == port)
+            return &subscriber;
+    }
+    return nullptr;
+}
+
+void OSCCommunication::subscriberPinged(int port, juce::int32 pid, int deviceMask) {
+    if (!senderConnected)
+        return;
+    
+    const juce::ScopedLock lock(subscriberLock);
+    auto subscriber = findSubscriber(port);
+    if (subscriber == nullptr) {
+        subscriber = findSubscriber(-1);
+        auto sender = std::make_unique<juce::OSCSender>();
+        if (subscriber == nullptr || !sender->connect(senderIP, port)) {
+            subscribersRejected.add();
+            return;
+        }
+        
+        std::cout << "Mapper connected on port " << port << std::endl;
+        subscriber->port = port;
+        subscriber->sender = std::move(sender);
+    }
+    // devices the subscriber did not get so far, so it can set up their lights
+    auto newDevices = deviceMask & ~subscriber->deviceMask;
+    for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
+        if (newDevices & (1 << (int)i->type))
+            sendDevice(*subscriber->sender, i->type, i->instance);
+    }
+    subscriber->pid = pid;
+    subscriber->deviceMask = deviceMask;
+    subscriber->pingCounter = 0;
+    updateSubscriberState();
+}
+
+void OSCCommunication::removeSubscriber(Subscriber &subscriber) {
+    subscriber.sender = nullptr;
+    subscriber.port = -1;
+    subscriber.pid = 0;
+    subscriber.deviceMask = 0;
+    subscriber.pingCounter = 0;
+    subscriber.subscribed = false;
+}
+
+bool OSCCommunication::isServedByLocalLink(const Subscriber &subscriber) const {
+    return subscriber.pid != 0 && subscriber.pid == localLink.getConsumerPid();
+}
+
+bool OSCCommunication::subscriberWants(const Subscriber &subscriber, const OSC::Message &msg) const {
+    int device = (int)msg.device;
+    if (!subscriber.subscribed || device < (int)EHDeviceType::Alpha || device > (int)EHDeviceType::Pico)
+        return true;
+    return Subscription::wants(subscriber.filters[device - 1], msg, msg.transition != 0);
+}
+
+bool OSCCommunication::isWanted(const OSC::Message &msg) {
+    int device = (int)msg.device;
+    if (device < (int)EHDeviceType::Alpha || device > (int)EHDeviceType::Pico
+        || Subscription::wants(wanted[device - 1], msg, msg.transition != 0))
+        return true;
+    messagesFiltered.add();
+    return false;
+}
+
+// /ECMapper/subscribe port device flags keys[12] expression[12], see Subscription.h
+void OSCCommunication::subscriptionReceived(const juce::OSCMessage &message) {
+    if (message.size() != 2 + Subscription::ArgumentCount || !allInt32(message)
+        || message[1].getInt32() < (int)EHDeviceType::Alpha || message[1].getInt32() > (int)EHDeviceType::Pico) {
+        messagesRejected.add();
+        return;
+    }
+    
+    const juce::ScopedLock lock(subscriberLock);
+    // not registered yet, the subscription comes again after a later ping
+    auto port = message[0].getInt32();
+    auto subscriber = port == -1 ? nullptr : findSubscriber(port);
+    if (subscriber == nullptr)
+        return;
+    
+    if (!subscriber->subscribed) {
+        // nothing received so far means everything for the other devices
+        for (auto &filter : subscriber->filters)
+            filter = Subscription::DeviceFilter::everything();
+        subscriber->subscribed = true;
+    }
+    subscriber->filters[message[1].getInt32() - 1].readFrom(message, 2);
+    updateSubscriberState();
+}
+
+// call with subscriberLock held
+void OSCCommunication::updateSubscriberState() {
+    int count = 0;
+    bool needed = false;
+    Subscription::DeviceFilter merged[3];
+    for (auto &subscriber : subscribers) {
+        if (subscriber.port == -1)
+            continue;
+        count++;
+        needed |= !isServedByLocalLink(subscriber);
+        for (int i = 0; i < 3; i++) {
+            if (subscriber.deviceMask & (1 << (i + 1)))
+                merged[i].merge(subscriber.subscribed ? subscriber.filters[i] : Subscription::DeviceFilter::everything());
+        }
+    }
+    for (int i = 0; i < 3; i++)
+        wanted[i].store(merged[i]);
+    subscriberCount = count;
+    udpNeeded = needed;
+    mapperConnected = count > 0;
+}
+
 bool OSCCommunication::connectReceiver(int port)  {
     this->receiverPort = port;
     receiverConnected = true;
@@ -51,7 +186,17 @@ void OSCCommunication::disconnectReceiver() {
 }
 
 void OSCCommunication::oscMessageReceived(const juce::OSCMessage &message) {
-    if (message.getAddressPattern() == "/ECMapper/led" && message.size() == 4) {
+    auto receiveTime = LatencyTrace::nowMicros();
+    if (message.getAddressPattern() == "/ECMapper/led" && (message.size() == 4 || message.size() == 5)) {
+        // drop LEDs for keys the instrument doesn't have instead of writing past assignedLEDColours
+        if (!allInt32(message)
+            || !DeviceGeometry::isValid(message[3].getInt32())
+            || DeviceGeometry::keyIndex(message[3].getInt32(), message[0].getInt32(), message[1].getInt32()) < 0
+            || (message.size() == 5 && message[4].getInt32() < OSC::AllInstances)) {
+            messagesRejected.add();
+            return;
+        }
+
         msg = {
             .type = OSC::MessageType::LED,
             .course = (unsigned int)message[0].getInt32(),
@@ -63,12 +208,18 @@ void OSCCommunication::oscMessageReceived(const juce::OSCMessage &message) {
             .yaw = 0,
             .strip = 0,
             .pedal = 0,
-            .device = (EHDeviceType)message[3].getInt32()
+            .device = (EHDeviceType)message[3].getInt32(),
+            .instance = message.size() == 5 ? message[4].getInt32() : OSC::AllInstances
         };
 
         receiveQueue->add(&msg);
     }
     else if (message.getAddressPattern() == "/ECMapper/reset" && message.size() == 1) {
+        if (!message[0].isInt32()) {
+            messagesRejected.add();
+            return;
+        }
+
         msg = {
             .type = OSC::MessageType::Reset,
             .course = 0,
@@ -80,65 +231,92 @@ void OSCCommunication::oscMessageReceived(const juce::OSCMessage &message) {
             .yaw = 0,
             .strip = 0,
             .pedal = 0,
-            .device = (EHDeviceType)message[0].getInt32()
+            .device = (EHDeviceType)message[0].getInt32(),
+            .instance = OSC::AllInstances
         };
 
         receiveQueue->add(&msg);
     }
     else if (message.getAddressPattern() == "/ECMapper/ping") {
-        if (pingCounter == -1) {
-            mapperConnected = true;
-            std::cout << "Mapper connected" << std::endl;
-            pingCounter = 0;
-            for (auto i = begin(connectedDevices); i != end(connectedDevices); i++) {
-                sendDevice(i->type);
+        // Newer ECMappers send the port they listen on, their process id and the devices they map.
+        // Older ones send nothing and listen on the configured port.
+        if (message.size() == 3 && message[0].isInt32() && message[1].isInt32() && message[2].isInt32()) {
+            if (message[0].getInt32() <= 0 || message[0].getInt32() > 65535) {
+                messagesRejected.add();
+                return;
             }
+            subscriberPinged(message[0].getInt32(), message[1].getInt32(), message[2].getInt32());
+        }
+        else {
+            subscriberPinged(senderPort, 0, ~0);
         }
-        pingCounter = 0;
+    }
+    else if (message.getAddressPattern() == "/ECMapper/subscribe") {
+        subscriptionReceived(message);
+    }
+    else if (message.getAddressPattern() == "/ECMapper/probe" && (message.size() == 2 || message.size() == 3) && message[0].isInt32() && message[1].isInt32()) {
+        int port = message.size() == 3 && message[2].isInt32() ? message[2].getInt32() : senderPort;
+        const juce::ScopedLock lock(subscriberLock);
+        auto subscriber = findSubscriber(port);
+        if (subscriber != nullptr)
+            subscriber->sender->send("/EigenCore/probeReply", message[0].getInt32(), message[1].getInt32(), (int)receiveTime, (int)LatencyTrace::nowMicros());
+    }
+    else if (message.getAddressPattern() == "/ECMapper/probeReply" && message.size() == 4
+             && message[0].isInt32() && message[1].isInt32() && message[2].isInt32() && message[3].isInt32()) {
+        echoProbe.replyReceived(message[0].getInt32(), (juce::uint32)message[1].getInt32(), (juce::uint32)message[2].getInt32(), (juce::uint32)message[3].getInt32(), receiveTime);
     }
 }
 
-void OSCCommunication::sendDevice(const EHDeviceType deviceType) {
-    if (pingCounter > -1)
-        sender.send("/EigenCore/device", (int)deviceType);
+// The instance goes last, ECMappers that predate it ignore it or take every message as instance 0
+void OSCCommunication::sendDevice(juce::OSCSender &target, const EHDeviceType deviceType, int instance) {
+    target.send("/EigenCore/device", (int)deviceType, instance);
 }
 
-void OSCCommunication::sendKey(unsigned course, unsigned key, bool a, unsigned p, int r, int y, EHDeviceType deviceType) {
-    if (pingCounter > -1)
-        sender.send("/EigenCore/key", (int)course, (int)key, (int)a, (int)p, (int)r, (int)y, (int)deviceType);
+void OSCCommunication::sendKey(juce::OSCSender &target, unsigned course, unsigned key, bool a, unsigned p, int r, int y, EHDeviceType deviceType, int instance, juce::uint32 callbackTime, juce::uint32 sendTime) {
+    target.send("/EigenCore/key", (int)course, (int)key, (int)a, (int)p, (int)r, (int)y, (int)deviceType, (int)callbackTime, (int)sendTime, instance);
 }
 
-void OSCCommunication::sendBreath(unsigned val, EHDeviceType deviceType) {
-    if (pingCounter > -1)
-        sender.send("/EigenCore/breath", (int)val, (int)deviceType);
+void OSCCommunication::sendBreath(juce::OSCSender &target, unsigned val, EHDeviceType deviceType, int instance) {
+    target.send("/EigenCore/breath", (int)val, (int)deviceType, instance);
 }
 
-void OSCCommunication::sendStrip(unsigned strip, unsigned val, bool active, EHDeviceType deviceType) {
-    if (pingCounter > -1)
-        sender.send("/EigenCore/strip", (int)strip, (int)val, active, (int)deviceType);
+void OSCCommunication::sendStrip(juce::OSCSender &target, unsigned strip, unsigned val, bool active, EHDeviceType deviceType, int instance) {
+    target.send("/EigenCore/strip", (int)strip, (int)val, active, (int)deviceType, instance);
 }
 
-void OSCCommunication::sendPedal(unsigned pedal, unsigned val, EHDeviceType deviceType) {
-    if (pingCounter > -1)
-        sender.send("/EigenCore/pedal", (int)pedal, (int)val, (int)deviceType);
+void OSCCommunication::sendPedal(juce::OSCSender &target, unsigned pedal, unsigned val, EHDeviceType deviceType, int instance) {
+    target.send("/EigenCore/pedal", (int)pedal, (int)val, (int)deviceType, instance);
 }
 
 void OSCCommunication::timerCallback() {
     if (!senderConnected)
         return;
     
-    sender.send("/EigenCore/ping");
-    if (pingCounter > -1)
-        pingCounter++;
-    
-    if (pingCounter > 15) {
-        mapperConnected = false;
-        std::cout << "Connection to Mapper timed out" << std::endl;
-        pingCounter = -1;
+    const juce::ScopedLock lock(subscriberLock);
+    bool probed = false;
+    for (auto &subscriber : subscribers) {
+        if (subscriber.port == -1)
+            continue;
+        
+        subscriber.sender->send("/EigenCore/ping", LocalLink::currentProcessId());
+        // one EchoProbe, so only the first subscriber is probed
+        if (!probed) {
+            auto sentTime = LatencyTrace::nowMicros();
+            subscriber.sender->send("/EigenCore/probe", echoProbe.prepareProbe(sentTime), (int)sentTime);
+            probed = true;
+        }
+        
+        if (++subscriber.pingCounter > SUBSCRIBER_TIMEOUT_PINGS) {
+            pingTimeouts.add();
+            std::cout << "Connection to Mapper on port " << subscriber.port << " timed out" << std::endl;
+            removeSubscriber(subscriber);
+        }
     }
+    updateSubscriberState();
 }
 
 void* OSCCommunication::sendProcess() {
+    SpanTrace::setThreadName("sendProcess");
     while (!exitThreads) {
 #ifdef MEASURE_OSCSENDPROCESSTIME
         static int counter = 0;
@@ -146,29 +324,51 @@ void* OSCCommunication::sendProcess() {
 #endif
         static OSC::Message msg;
         while (sendQueue->getMessageCount() > 0) {
+            TRACE_SPAN("OSC send");
             sendQueue->read(&msg);
-            if (!senderConnected)
+            if (!senderConnected || subscriberCount == 0) {
+                messagesDropped.add();
                 continue;
-
-            switch (msg.type) {
-                case OSC::MessageType::Key:
-                    sendKey(msg.course, msg.key, msg.active, msg.pressure, msg.roll, msg.yaw, msg.device);
-                    break;
-                case OSC::MessageType::Breath:
-                    sendBreath(msg.value, msg.device);
-                    break;
-                case OSC::MessageType::Strip:
-                    sendStrip(msg.strip, msg.value, msg.active, msg.device);
-                    break;
-                case OSC::MessageType::Pedal:
-                    sendPedal(msg.pedal, msg.value, msg.device);
-                    break;
-                case OSC::MessageType::Device:
-                    sendDevice(msg.device);
-                    break;
-                default:
-                    break;
             }
+            
+            juce::uint32 sendTime = 0;
+            if (msg.type == OSC::MessageType::Key) {
+                sendTime = LatencyTrace::nowMicros();
+                latencyTrace->record(LatencyTrace::CallbackToSend, msg.callbackTime, sendTime);
+            }
+            
+            bool sent = false;
+            const juce::ScopedLock lock(subscriberLock);
+            for (auto &subscriber : subscribers) {
+                if (subscriber.port == -1 || !(subscriber.deviceMask & (1 << (int)msg.device)) || isServedByLocalLink(subscriber)
+                    || !subscriberWants(subscriber, msg))
+                    continue;
+                sent = true;
+                auto &target = *subscriber.sender;
+                switch (msg.type) {
+                    case OSC::MessageType::Key:
+                        sendKey(target, msg.course, msg.key, msg.active, msg.pressure, msg.roll, msg.yaw, msg.device, msg.instance, msg.callbackTime, sendTime);
+                        break;
+                    case OSC::MessageType::Breath:
+                        sendBreath(target, msg.value, msg.device, msg.instance);
+                        break;
+                    case OSC::MessageType::Strip:
+                        sendStrip(target, msg.strip, msg.value, msg.active, msg.device, msg.instance);
+                        break;
+                    case OSC::MessageType::Pedal:
+                        sendPedal(target, msg.pedal, msg.value, msg.device, msg.instance);
+                        break;
+                    case OSC::MessageType::Device:
+                        sendDevice(target, msg.device, msg.instance);
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if (sent)
+                messagesSent.add();
+            else
+                messagesFiltered.add();
         }
 #ifdef MEASURE_OSCSENDPROCESSTIME
         auto end = std::chrono::high_resolution_clock::now();
@@ -5,34 +5,72 @@
 #include <thread>
 #include "OSCMessageQueue.h"
 #include "Common.h"
+#include "LatencyTrace.h"
+#include "Metrics.h"
+#include "SpanTrace.h"
+#include "EchoProbe.h"
+#include "LocalLink.h"
+#include "Subscription.h"
 
 #define MSGPROCESS_MICROSEC_SLEEP 100
+#define MAX_SUBSCRIBERS 8
+#define SUBSCRIBER_TIMEOUT_PINGS 15
 //#define MEASURE_OSCSENDPROCESSTIME
 
 struct ConnectedDevice;
 
 class OSCCommunication : private juce::OSCReceiver::Listener<juce::OSCReceiver::MessageLoopCallback>, juce::Timer {
 public:
-    OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue);
+    OSCCommunication(OSC::OSCMessageFifo *sendQueue, OSC::OSCMessageFifo *receiveQueue, LatencyTrace *latencyTrace, Metrics::Registry &metrics);
     ~OSCCommunication();
     bool connectSender(juce::String ip, int port);
     void disconnectSender();
     bool connectReceiver(int port);
     void disconnectReceiver();
     
-    void sendKey(unsigned course, unsigned key, bool a, unsigned p, int r, int y, EHDeviceType deviceType);
-    void sendDevice(EHDeviceType deviceType);
-    void sendBreath(unsigned val, EHDeviceType deviceType);
-    void sendStrip(unsigned strip, unsigned val, bool active, EHDeviceType deviceType);
-    void sendPedal(unsigned pedal, unsigned val, EHDeviceType deviceType);
+    void sendKey(juce::OSCSender &target, unsigned course, unsigned key, bool a, unsigned p, int r, int y, EHDeviceType deviceType, int instance, juce::uint32 callbackTime, juce::uint32 sendTime);
+    void sendDevice(juce::OSCSender &target, EHDeviceType deviceType, int instance);
+    void sendBreath(juce::OSCSender &target, unsigned val, EHDeviceType deviceType, int instance);
+    void sendStrip(juce::OSCSender &target, unsigned strip, unsigned val, bool active, EHDeviceType deviceType, int instance);
+    void sendPedal(juce::OSCSender &target, unsigned pedal, unsigned val, EHDeviceType deviceType, int instance);
+    LocalLink::Producer* getLocalLink() { return &localLink; }
+    // false while every subscriber gets its data through the local link, the send queue can be skipped then
+    bool needsUDP() const { return udpNeeded.load(std::memory_order_relaxed); }
+    // false when no subscriber maps what msg carries, from the EigenLite callback thread
+    bool isWanted(const OSC::Message &msg);
 
     OSC::OSCMessageFifo *sendQueue;
 private:
-    juce::OSCSender sender;
+    // One ECMapper instance, registered by its first ping and dropped when its pings stop.
+    // Data goes to every subscriber whose device mask has the message's device and, once it sent
+    // /ECMapper/subscribe, whose filter for that device lets it through.
+    struct Subscriber {
+        int port = -1; // -1 for a free slot
+        juce::int32 pid = 0;
+        int deviceMask = 0; // bit per EHDeviceType
+        int pingCounter = 0;
+        bool subscribed = false;
+        Subscription::DeviceFilter filters[3]; // Alpha, Tau, Pico
+        std::unique_ptr<juce::OSCSender> sender;
+    };
+    
+    Subscriber subscribers[MAX_SUBSCRIBERS];
+    juce::CriticalSection subscriberLock;
+    std::atomic<int> subscriberCount { 0 };
+    std::atomic<bool> udpNeeded { true };
+    Subscription::SharedDeviceFilter wanted[3]; // every subscriber's filters merged, read by isWanted()
     juce::String senderIP;
     int senderPort = -1;
     bool senderConnected = false;
     
+    Subscriber* findSubscriber(int port);
+    void subscriberPinged(int port, juce::int32 pid, int deviceMask);
+    void removeSubscriber(Subscriber &subscriber);
+    bool isServedByLocalLink(const Subscriber &subscriber) const;
+    bool subscriberWants(const Subscriber &subscriber, const OSC::Message &msg) const;
+    void subscriptionReceived(const juce::OSCMessage &message);
+    void updateSubscriberState();
+    
     juce::OSCReceiver receiver;
     juce::String receiverIP;
     int receiverPort = -1;
@@ -41,11 +79,19 @@ private:
     void oscMessageReceived(const juce::OSCMessage& message) override;
     void timerCallback() override;
     
-    int pingCounter = -1;
     int pingInterval = 100;
     
     OSC::OSCMessageFifo *receiveQueue;
     OSC::Message msg;
+    LatencyTrace *latencyTrace;
+    Metrics::Counter &messagesSent;
+    Metrics::Counter &messagesDropped;
+    Metrics::Counter &pingTimeouts;
+    Metrics::Counter &messagesRejected;
+    Metrics::Counter &messagesFiltered;
+    Metrics::Counter &subscribersRejected;
+    EchoProbe echoProbe;
+    LocalLink::Producer localLink;
     
     void* sendProcess();
     std::thread sendProcessThread;
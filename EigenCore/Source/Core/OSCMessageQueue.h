@@ -28,8 +28,13 @@ struct Message {
     unsigned int pedal = 0;
     unsigned int value = 0;
     EHDeviceType device = EHDeviceType::None;
+    juce::uint32 callbackTime = 0; // LatencyTrace::nowMicros() in APICallback, key messages only
+    int transition = 0; // key messages, 1 for a press or a release, see Subscription.h
+    int instance = 0; // which instrument of its type, see ConnectedDevice. LEDs: AllInstances for every one.
 };
 
+const int MaxInstances = 4; // instruments of one type, ECMapper rejects higher instances
+const int AllInstances = -1;
 const int MessageSize = sizeof(Message)/sizeof(int);
 const int queueSize = 1024;
 
@@ -38,7 +43,9 @@ public:
     void add(const Message *message);
     void read(Message *message);
     int getMessageCount() const;
+    juce::int64 getOverflowCount() const { return overflowCount.load(std::memory_order_relaxed); }
 private:
+    std::atomic<juce::int64> overflowCount { 0 };
     juce::AbstractFifo fifo { queueSize * MessageSize };
     int buffer[queueSize * MessageSize];
 };
@@ -0,0 +1,136 @@
+#include "SimulatedBackend.h"
+
+SimulatedBackend::SimulatedBackend(const juce::String &config) {
+    juce::StringArray deviceConfigs;
+    deviceConfigs.addTokens(config, ",", "");
+    for (int i = 0; i < deviceConfigs.size(); i++)
+        addDevice(deviceConfigs[i].trim(), i);
+}
+
+void SimulatedBackend::addDevice(const juce::String &deviceConfig, int index) {
+    juce::StringArray parts;
+    parts.addTokens(deviceConfig, ":", "");
+    if (parts.isEmpty())
+        return;
+    
+    SimDevice device;
+    auto typeName = parts[0].toLowerCase();
+    if (typeName == "alpha") {
+        device.type = EHDeviceType::Alpha;
+        device.apiType = EigenApi::Callback::DeviceType::ALPHA;
+        device.rows = 24;
+        device.pedals = 4;
+    }
+    else if (typeName == "tau") {
+        device.type = EHDeviceType::Tau;
+        device.apiType = EigenApi::Callback::DeviceType::TAU;
+        device.rows = 21;
+        device.pedals = 2;
+    }
+    else if (typeName == "pico") {
+        device.type = EHDeviceType::Pico;
+        device.apiType = EigenApi::Callback::DeviceType::PICO;
+        device.rows = 9;
+        device.pedals = 0;
+    }
+    else {
+        std::cout << "Unknown simulator device: " << parts[0] << std::endl;
+        return;
+    }
+    
+    auto &geometry = DeviceGeometry::get((int)device.type);
+    device.cols = geometry.cols;
+    device.ribbons = geometry.strips;
+    for (int i = 0; i < DeviceGeometry::keyCount((int)device.type); i++)
+        device.keys.push_back({ (unsigned)DeviceGeometry::courseOf((int)device.type, i), (unsigned)DeviceGeometry::keyOf((int)device.type, i) });
+    
+    int keyCount = parts.size() > 1 ? parts[1].getIntValue() : (int)device.keys.size();
+    device.keys.resize(juce::jlimit(0, (int)device.keys.size(), keyCount));
+    double scanRate = parts.size() > 2 ? parts[2].getDoubleValue() : 2000.0;
+    device.scanInterval = 1.0/juce::jmax(1.0, scanRate);
+    device.dev = "sim" + std::to_string(index) + ":" + typeName.toStdString();
+    devices.push_back(device);
+    
+    std::cout << "Simulating " << device.dev << ", " << device.keys.size() << " keys at " << scanRate << " scans/s" << std::endl;
+}
+
+bool SimulatedBackend::start() {
+    startTime = std::chrono::steady_clock::now();
+    for (auto &device : devices) {
+        device.nextScan = 0.0;
+        device.scanCount = 0;
+        for (auto callback : callbacks)
+            callback->device(device.dev.c_str(), device.apiType, device.rows, device.cols, device.ribbons, device.pedals);
+    }
+    running = true;
+    return !devices.empty();
+}
+
+void SimulatedBackend::stop() {
+    if (!running)
+        return;
+    
+    running = false;
+    for (auto &device : devices) {
+        for (auto callback : callbacks)
+            callback->disconnect(device.dev.c_str(), device.apiType);
+    }
+}
+
+bool SimulatedBackend::process() {
+    if (!running)
+        return false;
+    
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    for (auto &device : devices) {
+        int scans = 0;
+        while (device.nextScan <= now && scans < SIMULATOR_MAX_CATCHUP_SCANS) {
+            scan(device);
+            device.nextScan += device.scanInterval;
+            scans++;
+        }
+        // too far behind, skip ahead like a device dropping scans instead of bursting
+        if (device.nextScan <= now)
+            device.nextScan = now + device.scanInterval;
+    }
+    return true;
+}
+
+// Each key is held for 400 scans and released for 100, staggered so keys go on and off all the time
+void SimulatedBackend::scan(SimDevice &device) {
+    auto t = (unsigned long long)(device.nextScan*1000000.0);
+    auto dev = device.dev.c_str();
+    device.scanCount++;
+    
+    for (size_t i = 0; i < device.keys.size(); i++) {
+        int cyclePos = (int)((device.scanCount + i*37) % 500);
+        bool active = cyclePos < 400;
+        if (!active && cyclePos != 400)
+            continue;
+        
+        unsigned pressure = active ? 200 + (cyclePos*37)%3800 : 0;
+        int roll = ((cyclePos*13)%4096) - 2048;
+        int yaw = ((cyclePos*29 + (int)i*101)%4096) - 2048;
+        for (auto callback : callbacks)
+            callback->key(dev, t, device.keys[i].course, device.keys[i].key, active, pressure, roll, yaw);
+    }
+    
+    for (auto callback : callbacks)
+        callback->breath(dev, t, 2048 + (unsigned)((device.scanCount*7)%1500));
+    
+    if (device.scanCount%4 == 0) {
+        for (int strip = 1; strip <= device.ribbons; strip++) {
+            unsigned value = 150 + (unsigned)((device.scanCount*3 + strip*500)%3500);
+            for (auto callback : callbacks)
+                callback->strip(dev, t, strip, value, true);
+        }
+    }
+}
+
+void SimulatedBackend::addCallback(EigenApi::Callback *callback) {
+    callbacks.push_back(callback);
+}
+
+void SimulatedBackend::setLED(const char *dev, unsigned course, unsigned key, unsigned colour) {
+    ledWrites.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <JuceHeader.h>
+#include <eigenapi.h>
+#include <chrono>
+#include "DeviceBackend.h"
+#include "Enums.h"
+#include "DeviceGeometry.h"
+
+#define SIMULATOR_MAX_CATCHUP_SCANS 64
+
+// Generates Eigenharp traffic without hardware. Configured with a comma separated list of
+// device[:keys[:scanrate]], e.g. "alpha:132:2000,pico". keys is the number of keys being played
+// (all keys when left out) and scanrate the scans per second (default 2000).
+class SimulatedBackend : public DeviceBackend {
+public:
+    SimulatedBackend(const juce::String &config);
+    bool start() override;
+    void stop() override;
+    bool process() override;
+    void setPollTime(unsigned pollTime) override {}
+    void addCallback(EigenApi::Callback *callback) override;
+    void setLED(const char *dev, unsigned course, unsigned key, unsigned colour) override;
+
+private:
+    struct SimKey {
+        unsigned course;
+        unsigned key;
+    };
+    
+    struct SimDevice {
+        std::string dev;
+        EHDeviceType type = EHDeviceType::None;
+        EigenApi::Callback::DeviceType apiType;
+        int rows = 0;
+        int cols = 0;
+        int ribbons = 0;
+        int pedals = 0;
+        std::vector<SimKey> keys;
+        double scanInterval = 0.0005;
+        double nextScan = 0.0;
+        juce::uint64 scanCount = 0;
+    };
+    
+    void addDevice(const juce::String &deviceConfig, int index);
+    void scan(SimDevice &device);
+    
+    std::vector<SimDevice> devices;
+    std::vector<EigenApi::Callback*> callbacks;
+    std::chrono::steady_clock::time_point startTime;
+    bool running = false;
+};
@@ -6,7 +6,41 @@ EigenCoreAudioProcessorEditor::EigenCoreAudioProcessorEditor(EigenCoreAudioProce
 {
     ledGreen = juce::ImageFileFormat::loadFrom(BinaryData::GreenLight_png, BinaryData::GreenLight_pngSize);
     ledOff = juce::ImageFileFormat::loadFrom(BinaryData::DarkLight_png, BinaryData::DarkLight_pngSize);
-    setSize(200, 50);
+    
+    latencyLabel.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 10.0f, juce::Font::plain));
+    addAndMakeVisible(latencyLabel);
+    metricsLabel.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 10.0f, juce::Font::plain));
+    metricsLabel.setJustificationType(juce::Justification::topLeft);
+    addAndMakeVisible(metricsLabel);
+    dumpLatencyButton.setButtonText("Dump latency");
+    dumpLatencyButton.onClick = [this]
+    {
+        auto latencyTrace = audioProcessor.getLatencyTrace();
+        if (latencyTrace == nullptr)
+            return;
+        auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("EigenCore")
+            .getChildFile("latency_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".txt");
+        latencyTrace->dumpToFile(file);
+    };
+    addAndMakeVisible(dumpLatencyButton);
+    traceButton.setButtonText("Trace spans");
+    traceButton.setToggleState(SpanTrace::isEnabled(), juce::dontSendNotification);
+    traceButton.onClick = [this]
+    {
+        SpanTrace::setEnabled(traceButton.getToggleState());
+    };
+    addAndMakeVisible(traceButton);
+    dumpTraceButton.setButtonText("Dump trace");
+    dumpTraceButton.onClick = []
+    {
+        auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("EigenCore")
+            .getChildFile("trace_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".json");
+        SpanTrace::dumpToFile(file, "EigenCore");
+    };
+    addAndMakeVisible(dumpTraceButton);
+    
+    setSize(200, 272);
+    startTimer(500);
 }
 
 EigenCoreAudioProcessorEditor::~EigenCoreAudioProcessorEditor()
@@ -34,4 +68,23 @@ void EigenCoreAudioProcessorEditor::paint(juce::Graphics& g)
 
 void EigenCoreAudioProcessorEditor::resized()
 {
+    latencyLabel.setBounds(0, 50, getWidth(), 20);
+    dumpLatencyButton.setBounds(0, 72, 98, 22);
+    dumpTraceButton.setBounds(102, 72, 98, 22);
+    traceButton.setBounds(0, 96, getWidth(), 22);
+    metricsLabel.setBounds(0, 122, getWidth(), getHeight() - 122);
+}
+
+void EigenCoreAudioProcessorEditor::timerCallback()
+{
+    metricsLabel.setText(audioProcessor.getMetricsSummary(), juce::dontSendNotification);
+    
+    auto latencyTrace = audioProcessor.getLatencyTrace();
+    if (latencyTrace == nullptr)
+        return;
+    
+    auto &histogram = latencyTrace->getHistogram(LatencyTrace::CallbackToSend);
+    latencyLabel.setText("cb->send p50 " + juce::String(histogram.getPercentile(50.0))
+                         + " p99 " + juce::String(histogram.getPercentile(99.0))
+                         + " max " + juce::String(histogram.getMax()) + " us", juce::dontSendNotification);
 }
@@ -4,7 +4,7 @@
 #include "PluginProcessor.h"
 #include "Core/Enums.h"
 
-class EigenCoreAudioProcessorEditor  : public juce::AudioProcessorEditor
+class EigenCoreAudioProcessorEditor  : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     EigenCoreAudioProcessorEditor (EigenCoreAudioProcessor&);
@@ -16,7 +16,14 @@ public:
 private:
     juce::Image ledGreen;
     juce::Image ledOff;
+    juce::Label latencyLabel;
+    juce::Label metricsLabel;
+    juce::TextButton dumpLatencyButton;
+    juce::ToggleButton traceButton;
+    juce::TextButton dumpTraceButton;
     EigenCoreAudioProcessor& audioProcessor;
+    
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EigenCoreAudioProcessorEditor)
 };
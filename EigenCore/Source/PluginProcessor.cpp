@@ -1,9 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-volatile std::atomic<bool> exitThreads;
-std::atomic<bool> mapperConnected;
-std::list<ConnectedDevice> connectedDevices;
 static int instanceCount = 0;
 
 EigenCoreAudioProcessor::EigenCoreAudioProcessor()
@@ -19,6 +16,7 @@ EigenCoreAudioProcessor::EigenCoreAudioProcessor()
     addParameter(params[(int)ConnectionType::Alpha] = new juce::AudioParameterBool("alpha", "Alpha connected", false, juce::AudioParameterBoolAttributes()));
     addParameter(params[(int)ConnectionType::Mapper] = new juce::AudioParameterBool("mapper", "Mapper connected", false, juce::AudioParameterBoolAttributes()));
     addParameter(manualShutdown = new juce::AudioParameterBool("manualShutdown", "Manual shutdown", false));
+    addParameter(recordCapture = new juce::AudioParameterBool("recordCapture", "Record capture", false));
 
 //    eigenCore.initialiseCore("");
     startTimer(1000);
@@ -158,6 +156,16 @@ void EigenCoreAudioProcessor::shutdown()
         eigenCore->shutdownCore();
 }
 
+LatencyTrace* EigenCoreAudioProcessor::getLatencyTrace()
+{
+    return eigenCore != nullptr ? &eigenCore->getLatencyTrace() : nullptr;
+}
+
+juce::String EigenCoreAudioProcessor::getMetricsSummary()
+{
+    return eigenCore != nullptr ? eigenCore->getMetricsSummary() : juce::String();
+}
+
 void EigenCoreAudioProcessor::suspended()
 {
 //    if (eigenCore->isRunning())
@@ -206,5 +214,14 @@ void EigenCoreAudioProcessor::updateOutputParameters()
     {
         eigenCore->shutdownCore();
     }
+    
+    bool doCapture = *recordCapture;
+    if (eigenCore != nullptr && doCapture != eigenCore->isCapturing())
+    {
+        if (doCapture)
+            eigenCore->startCapture();
+        else
+            eigenCore->stopCapture();
+    }
 }
 
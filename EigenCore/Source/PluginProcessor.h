@@ -32,9 +32,12 @@ public:
     void suspended();
     void resumed();
     void shutdown();
+    LatencyTrace* getLatencyTrace();
+    juce::String getMetricsSummary();
 
     juce::AudioParameterBool* params[4];
     juce::AudioParameterBool* manualShutdown;
+    juce::AudioParameterBool* recordCapture;
     
 private:
     EigenCore *eigenCore = nullptr;
@@ -0,0 +1,95 @@
+#pragma once
+
+// The keys, strips and key rows of each instrument, for both plugins. Devices are indexed by their type value,
+// Alpha = 1, Tau = 2 and Pico = 3 in DeviceType and EHDeviceType alike, keys by the course and key number
+// EigenLite reports. Every key that exists has a flat index, course 0 first, so per-key state can be kept in
+// arrays sized to the instrument instead of [3][120].
+namespace DeviceGeometry {
+
+struct Course {
+    int firstKey; // key number of the first key, Tau course 1 starts at 5
+    int normalKeys;
+    int percKeys;
+    int buttons;
+
+    constexpr int keyCount() const { return normalKeys + percKeys + buttons; }
+};
+
+struct Device {
+    int cols; // as reported by EigenLite when the device connects
+    int strips;
+    Course courses[2];
+    int keyRows;
+    int keyRowLengths[5];
+
+    constexpr int keyCount() const { return courses[0].keyCount() + courses[1].keyCount(); }
+};
+
+constexpr Device devices[4] = {
+    { 0, 0, { { 0, 0, 0, 0 }, { 0, 0, 0, 0 } }, 0, { 0, 0, 0, 0, 0 } },              // None
+    { 5, 2, { { 0, 120, 0, 0 }, { 0, 0, 12, 0 } }, 5, { 24, 24, 24, 24, 24 } },      // Alpha
+    { 4, 1, { { 0, 72, 12, 0 }, { 5, 0, 0, 8 } }, 4, { 16, 16, 20, 20, 0 } },        // Tau
+    { 2, 1, { { 0, 18, 0, 0 }, { 0, 0, 0, 4 } }, 2, { 9, 9, 0, 0, 0 } }              // Pico
+};
+
+const int DeviceTypeCount = 3;
+constexpr int MaxKeys = devices[1].keyCount();
+// one instrument of each type packed back to back, see offset()
+constexpr int AllKeys = devices[1].keyCount() + devices[2].keyCount() + devices[3].keyCount();
+
+constexpr bool isValid(int deviceType) { return deviceType >= 1 && deviceType <= DeviceTypeCount; }
+
+constexpr const Device& get(int deviceType) { return devices[isValid(deviceType) ? deviceType : 0]; }
+
+constexpr int keyCount(int deviceType) { return get(deviceType).keyCount(); }
+
+// flat index of the key, -1 for a key the instrument doesn't have
+constexpr int keyIndex(int deviceType, int course, int key) {
+    return course < 0 || course > 1 || key < get(deviceType).courses[course].firstKey
+            || key >= get(deviceType).courses[course].firstKey + get(deviceType).courses[course].keyCount()
+        ? -1
+        : (course == 1 ? get(deviceType).courses[0].keyCount() : 0) + key - get(deviceType).courses[course].firstKey;
+}
+
+enum KeyKind {
+    NormalKey,
+    PercKey,
+    ButtonKey
+};
+
+// within a course normal keys come first, then percussion keys, then buttons
+constexpr KeyKind kindOf(int deviceType, int course, int key) {
+    return course < 0 || course > 1 || key - get(deviceType).courses[course].firstKey < get(deviceType).courses[course].normalKeys
+        ? NormalKey
+        : key - get(deviceType).courses[course].firstKey < get(deviceType).courses[course].normalKeys + get(deviceType).courses[course].percKeys
+            ? PercKey
+            : ButtonKey;
+}
+
+// 0 when no instrument has that many columns
+constexpr int deviceTypeForCols(int cols) {
+    return cols == devices[1].cols ? 1 : cols == devices[2].cols ? 2 : cols == devices[3].cols ? 3 : 0;
+}
+
+constexpr int courseOf(int deviceType, int index) { return index < get(deviceType).courses[0].keyCount() ? 0 : 1; }
+
+constexpr int keyOf(int deviceType, int index) {
+    return courseOf(deviceType, index) == 0
+        ? get(deviceType).courses[0].firstKey + index
+        : get(deviceType).courses[1].firstKey + index - get(deviceType).courses[0].keyCount();
+}
+
+// where the device's keys start when the key indexes of all types are packed into one range of AllKeys
+constexpr int offset(int deviceType) {
+    return deviceType <= 1 ? 0 : offset(deviceType - 1) + keyCount(deviceType - 1);
+}
+
+constexpr int deviceTypeAt(int packedIndex) {
+    return packedIndex < offset(2) ? 1 : packedIndex < offset(3) ? 2 : 3;
+}
+
+static_assert(keyIndex(2, 1, 5) == 84 && keyOf(2, 91) == 12 && keyCount(2) == 92, "Tau buttons follow course 0");
+static_assert(kindOf(2, 0, 72) == PercKey && kindOf(2, 1, 5) == ButtonKey && kindOf(1, 1, 0) == PercKey, "key kinds");
+static_assert(AllKeys == 246 && deviceTypeAt(offset(3)) == 3, "packed key range");
+
+}
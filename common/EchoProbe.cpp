@@ -0,0 +1,63 @@
+#include "EchoProbe.h"
+
+EchoProbe::EchoProbe(Metrics::Registry &metrics)
+    : roundTrips(metrics.addHistogram("probe_rtt")), probesSent(metrics.addCounter("probes_sent")), repliesReceived(metrics.addCounter("probe_replies")) {
+    metrics.addGauge("probe_jitter_us", [this] { return (juce::int64)jitter.load(std::memory_order_relaxed); });
+    metrics.addGauge("clock_offset_us", [this] { return (juce::int64)clockOffset.load(std::memory_order_relaxed); });
+}
+
+int EchoProbe::prepareProbe(juce::uint32 sentTime) {
+    auto sequence = nextSequence;
+    nextSequence = (nextSequence + 1) & 0x7fffffff;
+    auto &probe = probes[sequence % ECHO_PROBE_WINDOW];
+    probe.sequence = sequence;
+    probe.sentTime = sentTime;
+    probe.answered = false;
+    probesSent.add();
+    return sequence;
+}
+
+void EchoProbe::replyReceived(int sequence, juce::uint32 sentTime, juce::uint32 remoteReceiveTime, juce::uint32 remoteSendTime, juce::uint32 receiveTime) {
+    if (sequence < 0)
+        return;
+    auto &probe = probes[sequence % ECHO_PROBE_WINDOW];
+    // late replies, replies to an earlier session, duplicates
+    if (probe.sequence != sequence || probe.sentTime != sentTime || probe.answered)
+        return;
+    
+    juce::uint32 total = receiveTime - sentTime;
+    juce::uint32 remote = remoteSendTime - remoteReceiveTime;
+    if (total > 0x7fffffff || remote > total)
+        return;
+    
+    probe.answered = true;
+    probe.roundTrip = total - remote;
+    probe.offset = ((juce::int32)(remoteReceiveTime - sentTime) + (juce::int32)(remoteSendTime - receiveTime))/2;
+    repliesReceived.add();
+    roundTrips.add(probe.roundTrip);
+    
+    // RFC 3550 style smoothed jitter
+    if (previousRoundTrip != 0) {
+        auto difference = std::abs((juce::int32)probe.roundTrip - (juce::int32)previousRoundTrip);
+        auto currentJitter = jitter.load(std::memory_order_relaxed);
+        jitter.store(currentJitter + (difference - currentJitter)/16, std::memory_order_relaxed);
+    }
+    previousRoundTrip = probe.roundTrip;
+    
+    const Probe *fastest = nullptr;
+    for (auto &candidate : probes) {
+        if (candidate.answered && (fastest == nullptr || candidate.roundTrip < fastest->roundTrip))
+            fastest = &candidate;
+    }
+    clockOffset.store(fastest->offset, std::memory_order_relaxed);
+    offsetValid.store(true, std::memory_order_relaxed);
+}
+
+juce::uint32 EchoProbe::toLocalTime(juce::uint32 remoteTime) const {
+    if (remoteTime == 0 || !hasClockOffset())
+        return remoteTime;
+    auto offset = getClockOffset();
+    if (std::abs(offset) < ECHO_PROBE_SAME_CLOCK_MICROS)
+        return remoteTime;
+    return remoteTime - (juce::uint32)offset;
+}
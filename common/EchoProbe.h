@@ -0,0 +1,49 @@
+#pragma once
+#include <JuceHeader.h>
+#include "LatencyTrace.h"
+#include "Metrics.h"
+
+#define ECHO_PROBE_WINDOW 16
+#define ECHO_PROBE_SAME_CLOCK_MICROS 1000
+
+// Timestamped echo between EigenCore and ECMapper. Each side sends (sequence, t1) every ping tick, the other side
+// answers with (sequence, t1, t2, t3), its own receive and reply time. With t4 the local receive time:
+//   round trip   = (t4 - t1) - (t3 - t2)
+//   clock offset = ((t2 - t1) + (t3 - t4)) / 2, taken from the fastest probe of the last ECHO_PROBE_WINDOW
+// Both ends answer on the message thread, so the round trip includes message thread dispatch on one side.
+// Results go into the Metrics registry, so they show up wherever the metrics are shown.
+class EchoProbe {
+public:
+    EchoProbe(Metrics::Registry &metrics);
+    
+    // returns the sequence number to send along with sentTime
+    int prepareProbe(juce::uint32 sentTime);
+    void replyReceived(int sequence, juce::uint32 sentTime, juce::uint32 remoteReceiveTime, juce::uint32 remoteSendTime, juce::uint32 receiveTime);
+    
+    bool hasClockOffset() const { return offsetValid.load(std::memory_order_relaxed); }
+    // remote clock minus local clock in microseconds
+    juce::int32 getClockOffset() const { return clockOffset.load(std::memory_order_relaxed); }
+    // Maps a remote LatencyTrace timestamp to the local clock. On one machine both use the same clock,
+    // so timestamps are left alone unless the offset is clearly more than estimation noise.
+    juce::uint32 toLocalTime(juce::uint32 remoteTime) const;
+
+private:
+    struct Probe {
+        int sequence = -1;
+        juce::uint32 sentTime = 0;
+        juce::uint32 roundTrip = 0;
+        juce::int32 offset = 0;
+        bool answered = false;
+    };
+    
+    Probe probes[ECHO_PROBE_WINDOW];
+    int nextSequence = 0;
+    juce::uint32 previousRoundTrip = 0;
+    
+    LatencyHistogram &roundTrips;
+    Metrics::Counter &probesSent;
+    Metrics::Counter &repliesReceived;
+    std::atomic<juce::int32> jitter { 0 };
+    std::atomic<juce::int32> clockOffset { 0 };
+    std::atomic<bool> offsetValid { false };
+};
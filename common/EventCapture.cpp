@@ -0,0 +1,57 @@
+#include "EventCapture.h"
+
+namespace EventCapture {
+
+bool Writer::open(const juce::File &file) {
+    close();
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+    stream = std::make_unique<juce::FileOutputStream>(file, 1 << 16);
+    if (stream->failedToOpen()) {
+        stream.reset();
+        return false;
+    }
+    stream->writeInt((int)fileMagic);
+    stream->writeInt((int)fileVersion);
+    stream->writeInt((int)sizeof(Record));
+    recordCount = 0;
+    return true;
+}
+
+void Writer::write(const Record &record) {
+    if (stream == nullptr)
+        return;
+    stream->write(&record, sizeof(Record));
+    recordCount++;
+}
+
+void Writer::close() {
+    if (stream != nullptr)
+        stream->flush();
+    stream.reset();
+}
+
+bool Reader::open(const juce::File &file) {
+    close();
+    stream = std::make_unique<juce::FileInputStream>(file);
+    if (stream->failedToOpen()
+        || (juce::uint32)stream->readInt() != fileMagic
+        || (juce::uint32)stream->readInt() != fileVersion
+        || stream->readInt() != (int)sizeof(Record)) {
+        stream.reset();
+        return false;
+    }
+    return true;
+}
+
+bool Reader::read(Record &record) {
+    if (stream == nullptr)
+        return false;
+    return stream->read(&record, sizeof(Record)) == sizeof(Record);
+}
+
+void Reader::close() {
+    stream.reset();
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Binary capture of the raw EigenLite callback stream, written by EigenCore and read by the replay tools.
+// File layout: header (magic, version, record size) followed by fixed size little endian records.
+namespace EventCapture {
+
+enum EventType {
+    Device = 1,
+    Key = 2,
+    Breath = 3,
+    Strip = 4,
+    Pedal = 5,
+    Disconnect = 9
+};
+
+struct Record {
+    juce::uint64 eigenTime = 0;     // EigenLite timestamp, 0 for device/disconnect
+    juce::uint32 captureTime = 0;   // microseconds since the capture was started
+    juce::uint8 type = 0;
+    juce::uint8 device = 0;         // 1 = Alpha, 2 = Tau, 3 = Pico
+    juce::uint8 course = 0;
+    juce::uint8 active = 0;
+    juce::uint32 index = 0;         // key, strip or pedal number
+    juce::uint32 value = 0;         // pressure, breath, strip or pedal value
+    juce::int32 roll = 0;
+    juce::int32 yaw = 0;
+};
+
+static_assert(sizeof(Record) == 32, "EventCapture::Record is part of the file format");
+
+const juce::uint32 fileMagic = 0x50414345; // "ECAP"
+const juce::uint32 fileVersion = 1;
+const juce::String fileExtension = ".ecap";
+
+class Writer {
+public:
+    bool open(const juce::File &file);
+    void write(const Record &record);
+    void close();
+    bool isOpen() const { return stream != nullptr; }
+    juce::int64 getRecordCount() const { return recordCount; }
+private:
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::int64 recordCount = 0;
+};
+
+class Reader {
+public:
+    bool open(const juce::File &file);
+    bool read(Record &record);
+    void close();
+private:
+    std::unique_ptr<juce::FileInputStream> stream;
+};
+
+}
@@ -0,0 +1,48 @@
+#include "LatencyHistogram.h"
+
+int LatencyHistogram::getBucketIndex(juce::uint32 micros) {
+    if (micros < 2*subBucketCount)
+        return (int)micros;
+    int msb = juce::findHighestSetBit(micros);
+    int shift = msb - subBucketBits;
+    int sub = (int)(micros >> shift) - subBucketCount;
+    return 2*subBucketCount + (msb - subBucketBits - 1)*subBucketCount + sub;
+}
+
+juce::uint32 LatencyHistogram::getBucketUpperBound(int index) {
+    if (index < 2*subBucketCount)
+        return (juce::uint32)index;
+    int msb = (index - 2*subBucketCount)/subBucketCount + subBucketBits + 1;
+    int sub = (index - 2*subBucketCount)%subBucketCount;
+    int shift = msb - subBucketBits;
+    return (juce::uint32)((((juce::uint64)(subBucketCount + sub + 1)) << shift) - 1);
+}
+
+void LatencyHistogram::add(juce::uint32 micros) {
+    buckets[getBucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    auto prevMax = max.load(std::memory_order_relaxed);
+    while (micros > prevMax && !max.compare_exchange_weak(prevMax, micros, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto &bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+juce::uint32 LatencyHistogram::getPercentile(double percentile) const {
+    auto total = getCount();
+    if (total == 0)
+        return 0;
+    
+    auto target = (juce::uint64)std::ceil(percentile/100.0*(double)total);
+    juce::uint64 seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return std::min(getBucketUpperBound(i), getMax());
+    }
+    return getMax();
+}
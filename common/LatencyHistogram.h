@@ -0,0 +1,25 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Log-linear histogram of microsecond values (32 sub buckets per power of two, so about 3% resolution).
+// add() is lock-free and can be called from any thread, readers get a consistent enough snapshot for display.
+class LatencyHistogram {
+public:
+    static const int subBucketBits = 5;
+    static const int subBucketCount = 1 << subBucketBits;
+    static const int bucketCount = 2*subBucketCount + (32 - subBucketBits - 1)*subBucketCount;
+
+    void add(juce::uint32 micros);
+    void reset();
+    juce::uint64 getCount() const { return count.load(std::memory_order_relaxed); }
+    juce::uint32 getMax() const { return max.load(std::memory_order_relaxed); }
+    juce::uint32 getPercentile(double percentile) const;
+
+private:
+    static int getBucketIndex(juce::uint32 micros);
+    static juce::uint32 getBucketUpperBound(int index);
+
+    std::atomic<juce::uint32> buckets[bucketCount] {};
+    std::atomic<juce::uint64> count { 0 };
+    std::atomic<juce::uint32> max { 0 };
+};
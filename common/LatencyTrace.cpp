@@ -0,0 +1,54 @@
+#include "LatencyTrace.h"
+
+juce::uint32 LatencyTrace::nowMicros() {
+    return (juce::uint32)(juce::int64)(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks())*1.0e6);
+}
+
+const char* LatencyTrace::getStageName(Stage stage) {
+    switch (stage) {
+        case CallbackToSend: return "callback -> send";
+        case SendToReceive: return "send -> receive";
+        case ReceiveToDequeue: return "receive -> dequeue";
+        case DequeueToMidi: return "dequeue -> midi";
+        case CallbackToMidi: return "callback -> midi";
+        default: return "";
+    }
+}
+
+void LatencyTrace::record(Stage stage, juce::uint32 fromMicros, juce::uint32 toMicros) {
+    if (fromMicros == 0)
+        return;
+    juce::uint32 delta = toMicros - fromMicros;
+    if (delta > 0x7fffffff) // clocks from different machines
+        return;
+    histograms[stage].add(delta);
+}
+
+void LatencyTrace::reset() {
+    for (auto &histogram : histograms)
+        histogram.reset();
+}
+
+juce::String LatencyTrace::getStageSummary(Stage stage) const {
+    auto &histogram = histograms[stage];
+    return juce::String(getStageName(stage)).paddedRight(' ', 20)
+        + " n " + juce::String(histogram.getCount())
+        + "  p50 " + juce::String(histogram.getPercentile(50.0))
+        + "  p99 " + juce::String(histogram.getPercentile(99.0))
+        + "  p99.9 " + juce::String(histogram.getPercentile(99.9))
+        + "  max " + juce::String(histogram.getMax()) + " us";
+}
+
+juce::String LatencyTrace::getSummary() const {
+    juce::String summary;
+    for (int i = 0; i < StageCount; i++) {
+        if (histograms[i].getCount() > 0)
+            summary << getStageSummary((Stage)i) << juce::newLine;
+    }
+    return summary;
+}
+
+bool LatencyTrace::dumpToFile(const juce::File &file) const {
+    file.getParentDirectory().createDirectory();
+    return file.replaceWithText(juce::Time::getCurrentTime().toString(true, true) + juce::newLine + getSummary());
+}
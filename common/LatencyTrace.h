@@ -0,0 +1,32 @@
+#pragma once
+#include <JuceHeader.h>
+#include "LatencyHistogram.h"
+
+// Per stage latency of key events on their way from the EigenLite callback to the MIDI buffer.
+// Timestamps are microseconds of the system wide monotonic clock truncated to 32 bits, so stages
+// spanning EigenCore and ECMapper are only meaningful when both run on the same machine.
+class LatencyTrace {
+public:
+    enum Stage {
+        CallbackToSend = 0,     // EigenCore: APICallback::key until the OSC send thread picks it up
+        SendToReceive,          // OSC transport
+        ReceiveToDequeue,       // ECMapper: receive queue until processBlock reads it
+        DequeueToMidi,          // ECMapper: MidiGenerator until a MIDI event is in the buffer
+        CallbackToMidi,         // end to end
+        StageCount
+    };
+    
+    static juce::uint32 nowMicros();
+    static const char* getStageName(Stage stage);
+    
+    void record(Stage stage, juce::uint32 fromMicros, juce::uint32 toMicros);
+    const LatencyHistogram& getHistogram(Stage stage) const { return histograms[stage]; }
+    void reset();
+    
+    juce::String getSummary() const;
+    juce::String getStageSummary(Stage stage) const;
+    bool dumpToFile(const juce::File &file) const;
+
+private:
+    LatencyHistogram histograms[StageCount];
+};
@@ -0,0 +1,202 @@
+#include "LocalLink.h"
+#if ! JUCE_WINDOWS
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <signal.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+namespace LocalLink {
+
+static const juce::uint32 ringMagic = 0x45434c32; // "ECL2"
+
+// Lives in the shared segment, so only plain data and lock free atomics
+struct Ring {
+    juce::uint32 magic = ringMagic;
+    juce::uint32 recordSize = sizeof(Record);
+    juce::uint32 capacity = LOCAL_LINK_CAPACITY;
+    std::atomic<juce::int32> producerPid { 0 };
+    std::atomic<juce::int32> consumerPid { 0 };
+    std::atomic<bool> producerOpen { false };
+    std::atomic<bool> consumerAttached { false };
+    alignas(64) std::atomic<juce::uint32> writeIndex { 0 };
+    std::atomic<juce::uint32> dropped { 0 };
+    alignas(64) std::atomic<juce::uint32> readIndex { 0 };
+    Record records[LOCAL_LINK_CAPACITY];
+};
+
+static bool isCompatible(const Ring *ring) {
+    return ring->magic == ringMagic && ring->recordSize == sizeof(Record) && ring->capacity == LOCAL_LINK_CAPACITY;
+}
+
+#if JUCE_WINDOWS
+
+juce::int32 currentProcessId() { return 0; }
+static Ring* mapRing(int, bool) { return nullptr; }
+static void unmapRing(Ring*) {}
+static void removeRing(int) {}
+static bool processIsAlive(juce::int32) { return false; }
+
+#else
+
+juce::int32 currentProcessId() {
+    return (juce::int32)getpid();
+}
+
+static juce::String segmentName(int port) {
+    return "/ecmapper-link-" + juce::String(port);
+}
+
+static Ring* mapRing(int port, bool create) {
+    int fd = shm_open(segmentName(port).toRawUTF8(), create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+    if (fd < 0)
+        return nullptr;
+    
+    struct stat status;
+    bool sized = fstat(fd, &status) == 0
+        && ((size_t)status.st_size >= sizeof(Ring) || (create && status.st_size == 0 && ftruncate(fd, sizeof(Ring)) == 0));
+    void *memory = sized ? mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    return memory == MAP_FAILED ? nullptr : (Ring*)memory;
+}
+
+static void unmapRing(Ring *ring) {
+    munmap(ring, sizeof(Ring));
+}
+
+static void removeRing(int port) {
+    shm_unlink(segmentName(port).toRawUTF8());
+}
+
+static bool processIsAlive(juce::int32 pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+#endif
+
+Producer::~Producer() {
+    close();
+    releaseRetired();
+}
+
+bool Producer::open(int port) {
+    close();
+    // the callback thread of the previous session has been joined by now
+    releaseRetired();
+    auto mapped = mapRing(port, true);
+    if (mapped == nullptr)
+        return false;
+    
+    // another EigenCore sends on this port. A segment left behind by one that crashed is taken over.
+    if (isCompatible(mapped) && mapped->producerOpen && processIsAlive(mapped->producerPid)) {
+        unmapRing(mapped);
+        return false;
+    }
+    new (mapped) Ring();
+    mapped->producerPid = currentProcessId();
+    mapped->producerOpen = true;
+    this->port = port;
+    ring = mapped;
+    return true;
+}
+
+void Producer::close() {
+    auto closing = ring.exchange(nullptr);
+    if (closing == nullptr)
+        return;
+    closing->producerOpen = false;
+    removeRing(port);
+    // send() may still be running on the callback thread, unmapped on the next open() or in the destructor
+    retired = closing;
+}
+
+void Producer::releaseRetired() {
+    if (retired != nullptr)
+        unmapRing(retired);
+    retired = nullptr;
+}
+
+bool Producer::hasConsumer() const {
+    auto current = ring.load(std::memory_order_acquire);
+    return current != nullptr && current->consumerAttached.load(std::memory_order_acquire);
+}
+
+juce::int32 Producer::getConsumerPid() const {
+    auto current = ring.load(std::memory_order_acquire);
+    return current != nullptr && current->consumerAttached.load(std::memory_order_acquire) ? current->consumerPid.load(std::memory_order_relaxed) : 0;
+}
+
+bool Producer::send(const Record &record) {
+    auto current = ring.load(std::memory_order_acquire);
+    if (current == nullptr || !current->consumerAttached.load(std::memory_order_acquire))
+        return false;
+    
+    auto write = current->writeIndex.load(std::memory_order_relaxed);
+    if (write - current->readIndex.load(std::memory_order_acquire) >= LOCAL_LINK_CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        current->dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    current->records[write % LOCAL_LINK_CAPACITY] = record;
+    current->writeIndex.store(write + 1, std::memory_order_release);
+    sent.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+Consumer::~Consumer() {
+    detach();
+}
+
+bool Consumer::attach(int port, juce::int32 producerPid) {
+    detach();
+    auto mapped = mapRing(port, false);
+    if (mapped == nullptr)
+        return false;
+    
+    // the segment has to belong to the EigenCore that pinged, which also rules out one on another machine
+    if (!isCompatible(mapped) || mapped->producerPid != producerPid || !mapped->producerOpen) {
+        unmapRing(mapped);
+        return false;
+    }
+    // anything before this was written for an earlier consumer, the producer only writes while one is attached
+    auto start = mapped->writeIndex.load(std::memory_order_acquire);
+    bool expected = false;
+    if (!mapped->consumerAttached.compare_exchange_strong(expected, true) && processIsAlive(mapped->consumerPid)) {
+        unmapRing(mapped);
+        return false;
+    }
+    mapped->consumerPid = currentProcessId();
+    mapped->readIndex.store(start, std::memory_order_release);
+    ring = mapped;
+    this->producerPid = producerPid;
+    return true;
+}
+
+void Consumer::detach() {
+    if (ring == nullptr)
+        return;
+    ring->consumerAttached.store(false, std::memory_order_release);
+    unmapRing(ring);
+    ring = nullptr;
+}
+
+bool Consumer::isProducerOpen() const {
+    return ring != nullptr && ring->producerOpen.load(std::memory_order_relaxed) && ring->producerPid.load(std::memory_order_relaxed) == producerPid;
+}
+
+juce::int64 Consumer::getDroppedCount() const {
+    return ring != nullptr ? (juce::int64)ring->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+bool Consumer::pop(Record &record) {
+    auto read = ring->readIndex.load(std::memory_order_relaxed);
+    if (read == ring->writeIndex.load(std::memory_order_acquire))
+        return false;
+    record = ring->records[read % LOCAL_LINK_CAPACITY];
+    ring->readIndex.store(read + 1, std::memory_order_release);
+    return true;
+}
+
+}
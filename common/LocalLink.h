@@ -0,0 +1,79 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+#define LOCAL_LINK_CAPACITY 4096 // records, power of two
+
+// Single producer, single consumer ring in POSIX shared memory that carries EigenCore's data messages to an
+// ECMapper on the same machine, so keys skip OSC encoding, the loopback socket and OSC parsing. A full ring drops
+// the record instead of sending it over UDP, which could overtake the records still in the ring. EigenCore creates the segment for its send port and puts its process id into
+// its pings. An ECMapper listening on that port finds the segment, checks that it belongs to the pinging
+// process and attaches. From then on EigenCore's callbacks write to the ring instead of the OSC send queue.
+// Pings, probes and LEDs stay on OSC, and EigenCore goes back to UDP as soon as the consumer detaches.
+// Works the same when both plugins are loaded into one host process. Not available on Windows.
+namespace LocalLink {
+
+// One EigenCore data message: the fields of OSC::Message in both plugins, the device as its enum value
+struct Record {
+    juce::int32 type;
+    juce::uint32 course;
+    juce::uint32 key;
+    juce::int32 active;
+    juce::uint32 pressure;
+    juce::int32 roll;
+    juce::int32 yaw;
+    juce::uint32 strip;
+    juce::uint32 pedal;
+    juce::uint32 value;
+    juce::int32 device;
+    juce::uint32 callbackTime;
+    juce::uint32 sendTime;
+    juce::int32 instance;
+};
+
+struct Ring;
+
+juce::int32 currentProcessId();
+
+// EigenCore side, open() and close() on the message thread, send() from one thread only
+class Producer {
+public:
+    ~Producer();
+    bool open(int port);
+    void close();
+    bool hasConsumer() const;
+    // 0 when no consumer is attached
+    juce::int32 getConsumerPid() const;
+    // false when no ECMapper is attached, the caller sends over UDP instead. A full ring drops the record.
+    bool send(const Record &record);
+    juce::int64 getSentCount() const { return sent.load(std::memory_order_relaxed); }
+    juce::int64 getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<Ring*> ring { nullptr };
+    Ring *retired = nullptr;
+    int port = -1;
+    std::atomic<juce::int64> sent { 0 };
+    std::atomic<juce::int64> dropped { 0 };
+    void releaseRetired();
+};
+
+// ECMapper side, pop() from one thread at a time
+class Consumer {
+public:
+    ~Consumer();
+    // producerPid as sent in the EigenCore ping
+    bool attach(int port, juce::int32 producerPid);
+    void detach();
+    bool isAttached() const { return ring != nullptr; }
+    bool isProducerOpen() const;
+    bool pop(Record &record);
+    // records the producer dropped on a full ring since this ring was created
+    juce::int64 getDroppedCount() const;
+
+private:
+    Ring *ring = nullptr;
+    juce::int32 producerPid = 0;
+};
+
+}
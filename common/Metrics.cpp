@@ -0,0 +1,112 @@
+#include "Metrics.h"
+
+namespace Metrics {
+
+Registry::Registry(const juce::String &prefix) : prefix(prefix) {
+}
+
+Registry::Entry& Registry::addEntry(const juce::String &name, Type type) {
+    const juce::ScopedLock lock(registerLock);
+    entries.emplace_back();
+    auto &entry = entries.back();
+    entry.name = name;
+    entry.type = type;
+    return entry;
+}
+
+Counter& Registry::addCounter(const juce::String &name) {
+    return addEntry(name, CounterType).counter;
+}
+
+Gauge& Registry::addGauge(const juce::String &name) {
+    return addEntry(name, GaugeType).gauge;
+}
+
+LatencyHistogram& Registry::addHistogram(const juce::String &name) {
+    return addEntry(name, HistogramType).histogram;
+}
+
+void Registry::addCounter(const juce::String &name, std::function<juce::int64()> source) {
+    addEntry(name, CounterType).source = source;
+}
+
+void Registry::addGauge(const juce::String &name, std::function<juce::int64()> source) {
+    addEntry(name, GaugeType).source = source;
+}
+
+Sampler::Sampler(Registry &registry, const juce::String &exportSpec) : registry(registry) {
+    if (exportSpec.startsWith("file:")) {
+        exportFile = juce::File(exportSpec.fromFirstOccurrenceOf("file:", false, false));
+        exportFile.getParentDirectory().createDirectory();
+    }
+    else if (exportSpec.startsWith("udp:")) {
+        auto hostAndPort = exportSpec.fromFirstOccurrenceOf("udp:", false, false);
+        udpHost = hostAndPort.upToLastOccurrenceOf(":", false, false);
+        udpPort = hostAndPort.fromLastOccurrenceOf(":", false, false).getIntValue();
+        socket = std::make_unique<juce::DatagramSocket>();
+    }
+    previousTime = juce::Time::getMillisecondCounterHiRes();
+    startTimer(1000);
+}
+
+Sampler::~Sampler() {
+    stopTimer();
+}
+
+juce::int64 Sampler::getValue(const Registry::Entry &entry) const {
+    if (entry.source)
+        return entry.source();
+    if (entry.type == Registry::CounterType)
+        return entry.counter.get();
+    if (entry.type == Registry::GaugeType)
+        return entry.gauge.get();
+    return (juce::int64)entry.histogram.getCount();
+}
+
+void Sampler::timerCallback() {
+    auto &entries = registry.getEntries();
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    auto seconds = std::max((now - previousTime)/1000.0, 0.001);
+    previousTime = now;
+    previousValues.resize(entries.size(), 0);
+    
+    juce::String newSummary;
+    juce::String fileLine = juce::String(juce::Time::currentTimeMillis());
+    juce::String statsdLines;
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto &entry = entries[i];
+        auto value = getValue(entry);
+        auto statName = registry.prefix + "." + entry.name;
+        if (entry.type == Registry::CounterType) {
+            auto delta = value - previousValues[i];
+            newSummary << entry.name << " " << value << " (" << juce::String(delta/seconds, 1) << "/s)" << juce::newLine;
+            fileLine << " " << entry.name << "=" << value;
+            statsdLines << statName << ":" << delta << "|c\n";
+        }
+        else if (entry.type == Registry::GaugeType) {
+            newSummary << entry.name << " " << value << juce::newLine;
+            fileLine << " " << entry.name << "=" << value;
+            statsdLines << statName << ":" << value << "|g\n";
+        }
+        else {
+            auto p50 = entry.histogram.getPercentile(50.0);
+            auto p99 = entry.histogram.getPercentile(99.0);
+            auto max = entry.histogram.getMax();
+            newSummary << entry.name << " p50 " << (int)p50 << " p99 " << (int)p99 << " max " << (int)max << " us" << juce::newLine;
+            fileLine << " " << entry.name << ".p50=" << (int)p50 << " " << entry.name << ".p99=" << (int)p99 << " " << entry.name << ".max=" << (int)max;
+            statsdLines << statName << ".p99:" << (int)p99 << "|g\n" << statName << ".max:" << (int)max << "|g\n";
+        }
+        previousValues[i] = value;
+    }
+    summary = newSummary;
+    exportSample(fileLine, statsdLines);
+}
+
+void Sampler::exportSample(const juce::String &fileLine, const juce::String &statsdLines) {
+    if (exportFile != juce::File())
+        exportFile.appendText(fileLine + juce::newLine);
+    if (socket != nullptr && statsdLines.isNotEmpty())
+        socket->write(udpHost, udpPort, statsdLines.toRawUTF8(), (int)statsdLines.getNumBytesAsUTF8());
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <JuceHeader.h>
+#include <deque>
+#include <functional>
+#include "LatencyHistogram.h"
+
+// Runtime counters, gauges and histograms. Metrics are registered once at startup and then updated
+// from any thread with a relaxed atomic, the Sampler reads them on the message thread.
+namespace Metrics {
+
+class Counter {
+public:
+    void add(juce::int64 n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    juce::int64 get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<juce::int64> value { 0 };
+};
+
+class Gauge {
+public:
+    void set(juce::int64 newValue) { value.store(newValue, std::memory_order_relaxed); }
+    juce::int64 get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<juce::int64> value { 0 };
+};
+
+class Registry {
+public:
+    Registry(const juce::String &prefix);
+    
+    Counter& addCounter(const juce::String &name);
+    Gauge& addGauge(const juce::String &name);
+    LatencyHistogram& addHistogram(const juce::String &name);
+    // for values that already exist somewhere else, read when sampling
+    void addCounter(const juce::String &name, std::function<juce::int64()> source);
+    void addGauge(const juce::String &name, std::function<juce::int64()> source);
+    
+    enum Type { CounterType, GaugeType, HistogramType };
+    struct Entry {
+        juce::String name;
+        Type type;
+        Counter counter;
+        Gauge gauge;
+        LatencyHistogram histogram;
+        std::function<juce::int64()> source;
+    };
+    
+    const juce::String prefix;
+    // entries are only ever appended, references handed out stay valid for the lifetime of the registry
+    const std::deque<Entry>& getEntries() const { return entries; }
+
+private:
+    Entry& addEntry(const juce::String &name, Type type);
+    std::deque<Entry> entries;
+    juce::CriticalSection registerLock;
+};
+
+// Samples a Registry once a second on the message thread. Counters are also shown as a rate.
+// The export spec is "file:<path>" to append samples to a file or "udp:<host>:<port>" for statsd lines.
+class Sampler : private juce::Timer {
+public:
+    Sampler(Registry &registry, const juce::String &exportSpec = "");
+    ~Sampler() override;
+    juce::String getSummary() const { return summary; }
+
+private:
+    void timerCallback() override;
+    juce::int64 getValue(const Registry::Entry &entry) const;
+    void exportSample(const juce::String &fileLine, const juce::String &statsdLines);
+    
+    Registry &registry;
+    juce::String summary;
+    std::vector<juce::int64> previousValues;
+    double previousTime = 0.0;
+    
+    juce::File exportFile;
+    std::unique_ptr<juce::DatagramSocket> socket;
+    juce::String udpHost;
+    int udpPort = 0;
+};
+
+}
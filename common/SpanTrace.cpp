@@ -0,0 +1,115 @@
+#include "SpanTrace.h"
+#include <unistd.h>
+
+namespace SpanTrace {
+
+struct Event {
+    const char *name;
+    juce::int64 startTicks;
+    juce::int64 endTicks;
+};
+
+struct ThreadRing {
+    std::atomic<const char*> threadName { nullptr };
+    std::atomic<juce::uint32> writeIndex { 0 };
+    Event events[SPAN_TRACE_EVENTS_PER_THREAD];
+};
+
+static std::unique_ptr<ThreadRing[]> ringStorage;
+static juce::SpinLock ringStorageLock;
+static std::atomic<ThreadRing*> rings { nullptr };
+static std::atomic<int> ringCount { 0 };
+static std::atomic<bool> enabled { false };
+static thread_local ThreadRing *threadRing = nullptr;
+static thread_local const char *currentThreadName = nullptr;
+
+// Takes the next free ring, a thread that finds them all taken records nothing
+static ThreadRing* getThreadRing() {
+    if (threadRing != nullptr)
+        return threadRing;
+    
+    auto allRings = rings.load(std::memory_order_acquire);
+    if (allRings == nullptr)
+        return nullptr;
+    auto index = ringCount.load(std::memory_order_relaxed);
+    do {
+        if (index >= SPAN_TRACE_MAX_THREADS)
+            return nullptr;
+    } while (!ringCount.compare_exchange_weak(index, index + 1));
+    threadRing = &allRings[index];
+    threadRing->threadName.store(currentThreadName, std::memory_order_relaxed);
+    return threadRing;
+}
+
+void add(const char *name, juce::int64 startTicks, juce::int64 endTicks) {
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+    auto ring = getThreadRing();
+    if (ring == nullptr)
+        return;
+    
+    auto index = ring->writeIndex.load(std::memory_order_relaxed);
+    ring->events[index % SPAN_TRACE_EVENTS_PER_THREAD] = { name, startTicks, endTicks };
+    ring->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void setThreadName(const char *name) {
+    currentThreadName = name;
+    if (threadRing != nullptr)
+        threadRing->threadName.store(name, std::memory_order_relaxed);
+}
+
+void setEnabled(bool newEnabled) {
+    if (newEnabled) {
+        const juce::SpinLock::ScopedLockType lock(ringStorageLock);
+        if (ringStorage == nullptr) {
+            ringStorage.reset(new ThreadRing[SPAN_TRACE_MAX_THREADS]);
+            rings.store(ringStorage.get(), std::memory_order_release);
+        }
+    }
+    enabled = newEnabled;
+}
+
+bool isEnabled() {
+    return enabled;
+}
+
+// The rings keep being written while dumping, so the oldest events of a busy thread may already be
+// overwritten by the time they are read. Those show up as spans out of order and are harmless in the viewer.
+bool dumpToFile(const juce::File &file, const juce::String &processName) {
+    file.getParentDirectory().createDirectory();
+    juce::FileOutputStream stream(file);
+    if (stream.failedToOpen())
+        return false;
+    stream.setPosition(0);
+    stream.truncate();
+    
+    auto pid = (int)getpid();
+    auto ticksPerMicro = (double)juce::Time::getHighResolutionTicksPerSecond()/1.0e6;
+    stream << "{\"traceEvents\":[" << juce::newLine;
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"" << processName << "\"}}";
+    
+    auto allRings = rings.load(std::memory_order_acquire);
+    auto count = allRings != nullptr ? ringCount.load() : 0;
+    for (int tid = 0; tid < count; tid++) {
+        auto ring = &allRings[tid];
+        auto threadName = ring->threadName.load(std::memory_order_relaxed);
+        stream << "," << juce::newLine << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << (threadName != nullptr ? juce::String(threadName) : "thread " + juce::String(tid)) << "\"}}";
+        
+        auto end = ring->writeIndex.load(std::memory_order_acquire);
+        auto begin = end > SPAN_TRACE_EVENTS_PER_THREAD ? end - SPAN_TRACE_EVENTS_PER_THREAD : 0;
+        for (auto i = begin; i != end; i++) {
+            auto event = ring->events[i % SPAN_TRACE_EVENTS_PER_THREAD];
+            if (event.name == nullptr)
+                continue;
+            stream << "," << juce::newLine << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+                << ",\"ts\":" << juce::String(event.startTicks/ticksPerMicro, 1)
+                << ",\"dur\":" << juce::String((event.endTicks - event.startTicks)/ticksPerMicro, 1) << "}";
+        }
+    }
+    stream << juce::newLine << "]}" << juce::newLine;
+    return true;
+}
+
+}
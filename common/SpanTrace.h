@@ -0,0 +1,32 @@
+#pragma once
+#include <JuceHeader.h>
+
+#define SPAN_TRACE_MAX_THREADS 16
+#define SPAN_TRACE_EVENTS_PER_THREAD 65536
+
+// Timeline of pipeline spans for the Chrome trace viewer / Perfetto. Off until setEnabled(true), which allocates
+// the rings of all threads (kept until the process exits). Every thread then takes its own ring on its first span
+// and writes finished spans into it, dumpToFile() writes what is in the rings as Chrome trace JSON.
+// Span names must be string literals, only the pointer is stored.
+// Timestamps come from the monotonic clock, so dumps of EigenCore and ECMapper on the same machine line up.
+namespace SpanTrace {
+
+void add(const char *name, juce::int64 startTicks, juce::int64 endTicks);
+void setThreadName(const char *name);
+// call from the message thread, enabling allocates the rings the first time
+void setEnabled(bool enabled);
+bool isEnabled();
+bool dumpToFile(const juce::File &file, const juce::String &processName);
+
+class Scope {
+public:
+    Scope(const char *name) : name(name), startTicks(juce::Time::getHighResolutionTicks()) {}
+    ~Scope() { add(name, startTicks, juce::Time::getHighResolutionTicks()); }
+private:
+    const char *name;
+    juce::int64 startTicks;
+};
+
+}
+
+#define TRACE_SPAN(name) SpanTrace::Scope JUCE_JOIN_MACRO(traceSpan_, __LINE__)(name)
@@ -0,0 +1,124 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// What one ECMapper instance maps on one device, so EigenCore can drop everything else before it is
+// serialised. ECMapper sends it as
+//   /ECMapper/subscribe port device flags keys[12] expression[12]
+// whenever it changes and every SUBSCRIPTION_RESEND_PINGS pings. A key in keys gets its presses and releases,
+// one in expression also every pressure, roll and yaw update in between, which note keys need for their
+// velocity and expression. A subscriber that never sent a subscription gets everything.
+// Message types are compared by value, they are the same in both plugins.
+namespace Subscription {
+
+enum Flags {
+    Breath = 1,
+    Strip1 = 2,
+    Strip2 = 4,
+    Pedals = 8
+};
+
+const int WordsPerCourse = 4; // 120 keys in 32 bit words
+const int KeyWords = 3 * WordsPerCourse;
+const int ArgumentCount = 1 + 2 * KeyWords; // flags and both key sets, after port and device
+
+inline int wordIndex(unsigned int course, unsigned int key) { return (int)(course * WordsPerCourse + key / 32); }
+inline juce::uint32 bitFor(unsigned int key) { return 1u << (key % 32); }
+
+struct DeviceFilter {
+    juce::uint32 flags = 0;
+    juce::uint32 keys[KeyWords] = {};
+    juce::uint32 expression[KeyWords] = {};
+
+    void addKey(unsigned int course, unsigned int key, bool withExpression) {
+        keys[wordIndex(course, key)] |= bitFor(key);
+        if (withExpression)
+            expression[wordIndex(course, key)] |= bitFor(key);
+    }
+
+    void merge(const DeviceFilter &other) {
+        flags |= other.flags;
+        for (int i = 0; i < KeyWords; i++) {
+            keys[i] |= other.keys[i];
+            expression[i] |= other.expression[i];
+        }
+    }
+
+    bool operator==(const DeviceFilter &other) const {
+        return memcmp(this, &other, sizeof(DeviceFilter)) == 0;
+    }
+    bool operator!=(const DeviceFilter &other) const { return !(*this == other); }
+
+    static DeviceFilter everything() {
+        DeviceFilter filter;
+        filter.flags = ~0u;
+        for (int i = 0; i < KeyWords; i++) {
+            filter.keys[i] = ~0u;
+            filter.expression[i] = ~0u;
+        }
+        return filter;
+    }
+
+    void addTo(juce::OSCMessage &message) const {
+        message.addInt32((juce::int32)flags);
+        for (auto word : keys)
+            message.addInt32((juce::int32)word);
+        for (auto word : expression)
+            message.addInt32((juce::int32)word);
+    }
+
+    // firstArgument is the index of flags, the caller checked the size and that every argument is an int32
+    void readFrom(const juce::OSCMessage &message, int firstArgument) {
+        flags = (juce::uint32)message[firstArgument].getInt32();
+        for (int i = 0; i < KeyWords; i++) {
+            keys[i] = (juce::uint32)message[firstArgument + 1 + i].getInt32();
+            expression[i] = (juce::uint32)message[firstArgument + 1 + KeyWords + i].getInt32();
+        }
+    }
+};
+
+// The same for a reader on another thread, words are stored one by one, so a reader may see a mix of
+// the old and the new filter for a moment
+struct SharedDeviceFilter {
+    std::atomic<juce::uint32> flags { ~0u };
+    std::atomic<juce::uint32> keys[KeyWords];
+    std::atomic<juce::uint32> expression[KeyWords];
+
+    SharedDeviceFilter() { store(DeviceFilter::everything()); }
+
+    void store(const DeviceFilter &filter) {
+        for (int i = 0; i < KeyWords; i++) {
+            keys[i].store(filter.keys[i], std::memory_order_relaxed);
+            expression[i].store(filter.expression[i], std::memory_order_relaxed);
+        }
+        flags.store(filter.flags, std::memory_order_relaxed);
+    }
+};
+
+inline juce::uint32 load(juce::uint32 word) { return word; }
+inline juce::uint32 load(const std::atomic<juce::uint32> &word) { return word.load(std::memory_order_relaxed); }
+
+// Filter is a DeviceFilter or SharedDeviceFilter for the message's device. transition is true when a key
+// message is a press or a release.
+template <typename Filter, typename Message>
+bool wants(const Filter &filter, const Message &msg, bool transition) {
+    switch ((int)msg.type) {
+        case 2: { // Key
+            if (msg.course >= 3 || msg.key >= 120)
+                return true;
+            auto word = wordIndex(msg.course, msg.key);
+            auto bit = bitFor(msg.key);
+            return ((load(filter.expression[word]) | (transition ? load(filter.keys[word]) : 0u)) & bit) != 0;
+        }
+        case 3: // Breath
+            return (load(filter.flags) & Breath) != 0;
+        case 4: // Strip
+            return (load(filter.flags) & (msg.strip == 1 ? Strip1 : Strip2)) != 0;
+        case 5: // Pedal
+            return (load(filter.flags) & Pedals) != 0;
+        default:
+            return true;
+    }
+}
+
+}